@@ -88,6 +88,8 @@ namespace mcl
         // mulVec
         [DllImport(dllName)] public static extern int blsPublicKeyMulVec(ref PublicKey pub, in PublicKey pubVec, in SecretKey idVec, ulong n);
         [DllImport(dllName)] public static extern int blsSignatureMulVec(ref Signature sig, in Signature sigVec, in SecretKey idVec, ulong n);
+        [DllImport(dllName)] public static extern void blsPublicKeyMulVecMT(ref PublicKey pub, in PublicKey pubVec, in SecretKey idVec, ulong n, int threadN);
+        [DllImport(dllName)] public static extern void blsSignatureMulVecMT(ref Signature sig, in Signature sigVec, in SecretKey idVec, ulong n, int threadN);
         // zero
         [DllImport(dllName)] public static extern int blsSecretKeyIsZero(in SecretKey x);
         [DllImport(dllName)] public static extern int blsPublicKeyIsZero(in PublicKey x);
@@ -499,6 +501,24 @@ namespace mcl
             blsSignatureMulVec(ref sig, sigVec[0], secVec[0], (ulong)sigVec.Length);
             return sig;
         }
+        public static PublicKey MulVecMT(in PublicKey[] pubVec, in SecretKey[] secVec, int threadN)
+        {
+            if (pubVec.Length != secVec.Length) {
+                throw new ArithmeticException("PublicKey.MulVecMT");
+            }
+            PublicKey pub;
+            blsPublicKeyMulVecMT(ref pub, pubVec[0], secVec[0], (ulong)pubVec.Length, threadN);
+            return pub;
+        }
+        public static Signature MulVecMT(in Signature[] sigVec, in SecretKey[] secVec, int threadN)
+        {
+            if (sigVec.Length != secVec.Length) {
+                throw new ArithmeticException("Signature.MulVecMT");
+            }
+            Signature sig;
+            blsSignatureMulVecMT(ref sig, sigVec[0], secVec[0], (ulong)sigVec.Length, threadN);
+            return sig;
+        }
         public static bool FastAggregateVerify(in Signature sig, in PublicKey[] pubVec, byte[] msg)
         {
             if (pubVec.Length == 0) {
@@ -243,6 +243,8 @@ namespace mcl
             PublicKey aggPub = MulVec(pubVec, frVec);
             Signature aggSig = MulVec(sigVec, frVec);
             assert("mulVec", aggPub.Verify(aggSig, m));
+            assert("mulVecMT pub", aggPub.IsEqual(MulVecMT(pubVec, frVec, 4)));
+            assert("mulVecMT sig", aggSig.IsEqual(MulVecMT(sigVec, frVec, 4)));
         }
         static void TestFastAggregateVerify()
         {
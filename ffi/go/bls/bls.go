@@ -453,6 +453,16 @@ func (pub *PublicKey) Add(rhs *PublicKey) {
 	C.blsPublicKeyAdd(&pub.v, &rhs.v)
 }
 
+// MulVecMT -- pub = sum of pubVec[i] * secVec[i] with threadN threads
+func (pub *PublicKey) MulVecMT(pubVec []PublicKey, secVec []SecretKey, threadN int) error {
+	n := len(pubVec)
+	if n == 0 || n != len(secVec) {
+		return fmt.Errorf("err PublicKey.MulVecMT bad size")
+	}
+	C.blsPublicKeyMulVecMT(&pub.v, &pubVec[0].v, &secVec[0].v, C.mclSize(n), C.int(threadN))
+	return nil
+}
+
 // Set --
 func (pub *PublicKey) Set(mpk []PublicKey, id *ID) error {
 	if len(mpk) == 0 {
@@ -589,6 +599,16 @@ func (sig *Sign) Add(rhs *Sign) {
 	C.blsSignatureAdd(&sig.v, &rhs.v)
 }
 
+// MulVecMT -- sig = sum of sigVec[i] * secVec[i] with threadN threads
+func (sig *Sign) MulVecMT(sigVec []Sign, secVec []SecretKey, threadN int) error {
+	n := len(sigVec)
+	if n == 0 || n != len(secVec) {
+		return fmt.Errorf("err Sign.MulVecMT bad size")
+	}
+	C.blsSignatureMulVecMT(&sig.v, &sigVec[0].v, &secVec[0].v, C.mclSize(n), C.int(threadN))
+	return nil
+}
+
 // Recover --
 func (sig *Sign) Recover(sigVec []Sign, idVec []ID) error {
 	if len(sigVec) == 0 {
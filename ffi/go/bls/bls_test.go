@@ -239,6 +239,39 @@ func testAdd(t *testing.T) {
 	}
 }
 
+func testMulVecMT(t *testing.T) {
+	t.Log("testMulVecMT")
+	const n = 600
+	m := "test test"
+	secVec := make([]SecretKey, n)
+	pubVec := make([]PublicKey, n)
+	sigVec := make([]Sign, n)
+	coeffVec := make([]SecretKey, n)
+	for i := 0; i < n; i++ {
+		secVec[i].SetByCSPRNG()
+		pubVec[i] = *secVec[i].GetPublicKey()
+		sigVec[i] = *secVec[i].Sign(m)
+		coeffVec[i].SetByCSPRNG()
+	}
+	var pub1, pub4 PublicKey
+	var sig1, sig4 Sign
+	if pub1.MulVecMT(pubVec, coeffVec, 1) != nil || pub4.MulVecMT(pubVec, coeffVec, 4) != nil {
+		t.Fatal("PublicKey.MulVecMT")
+	}
+	if sig1.MulVecMT(sigVec, coeffVec, 1) != nil || sig4.MulVecMT(sigVec, coeffVec, 4) != nil {
+		t.Fatal("Sign.MulVecMT")
+	}
+	if !pub1.IsEqual(&pub4) || !sig1.IsEqual(&sig4) {
+		t.Error("MulVecMT threadN")
+	}
+	if !sig4.Verify(&pub4, m) {
+		t.Error("MulVecMT verify")
+	}
+	if pub1.MulVecMT(pubVec, coeffVec[1:], 1) == nil {
+		t.Error("MulVecMT bad size")
+	}
+}
+
 func testPop(t *testing.T) {
 	t.Log("testPop")
 	var sec SecretKey
@@ -585,6 +618,7 @@ func test(t *testing.T, c int) {
 	testPre(t)
 	testRecoverSecretKey(t)
 	testAdd(t)
+	testMulVecMT(t)
 	testSign(t)
 	testPop(t)
 	testData(t)
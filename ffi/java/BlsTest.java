@@ -183,6 +183,28 @@ public class BlsTest {
 		assertBool("aggSig.verify", aggSig.verify(aggPub, msg));
 		assertBool("fastAggregateVerify", aggSig.fastAggregateVerify(pubVec, msg));
 	}
+	public static void testMulVecMT() {
+		System.out.println("testMulVecMT");
+		int n = 600;
+		PublicKeyVec pubVec = new PublicKeyVec();
+		SignatureVec sigVec = new SignatureVec();
+		SecretKeyVec coeffVec = new SecretKeyVec();
+		byte[] msg = new byte[]{1, 2, 3, 5, 9};
+		for (int i = 0; i < n; i++) {
+			SecretKey sec = new SecretKey();
+			sec.setByCSPRNG();
+			pubVec.add(sec.getPublicKey());
+			sigVec.add(sec.sign(msg));
+			SecretKey coeff = new SecretKey();
+			coeff.setByCSPRNG();
+			coeffVec.add(coeff);
+		}
+		PublicKey aggPub = new PublicKey();
+		Signature aggSig = new Signature();
+		aggPub.mulVecMT(pubVec, coeffVec, 4);
+		aggSig.mulVecMT(sigVec, coeffVec, 4);
+		assertBool("mulVecMT", aggSig.verify(aggPub, msg));
+	}
 	public static void addVec(ByteArrayOutputStream os, PublicKeyVec pubVec, SignatureVec sigVec, int n, boolean isDiff) {
 		for (int i = 0; i < n; i++) {
 			byte[] msg = new byte[Bls.MSG_SIZE];
@@ -325,6 +347,7 @@ public class BlsTest {
 			testSign();
 			testShare();
 			testAggregateSignature();
+			testMulVecMT();
 			if (Bls.isDefinedBLS_ETH() && curveType == Bls.BLS12_381) {
 				System.out.println("BLS ETH mode");
 				testAggregateVerify();
@@ -215,6 +215,7 @@ public:
 	}
 	void share(const PublicKeyVec& secVec, const SecretKey& id);
 	void recover(const PublicKeyVec& secVec, const SecretKeyVec& idVec);
+	void mulVecMT(PublicKeyVec& pubVec, const SecretKeyVec& secVec, int threadN) _MCL_THROW;
 };
 
 class Signature {
@@ -287,6 +288,7 @@ public:
 		return blsVerifyHash(&self_, &pub.self_, cbuf, bufSize) == 1;
 	}
 	void recover(const SignatureVec& sigVec, const SecretKeyVec& idVec);
+	void mulVecMT(SignatureVec& sigVec, const SecretKeyVec& secVec, int threadN) _MCL_THROW;
 	void setHashOf(const char *cbuf, size_t bufSize) _MCL_THROW;
 	void aggregate(const SignatureVec& sigVec) _MCL_THROW
 	{
@@ -405,6 +407,24 @@ inline void Signature::recover(const SignatureVec& sigVec, const SecretKeyVec& i
 	}
 }
 
+inline void PublicKey::mulVecMT(PublicKeyVec& pubVec, const SecretKeyVec& secVec, int threadN) _MCL_THROW
+{
+	size_t n = pubVec.size();
+	if (n == 0 || n != secVec.size()) {
+		throw std::runtime_error("bad length");
+	}
+	blsPublicKeyMulVecMT(&self_, &pubVec[0].self_, &secVec[0].self_, n, threadN);
+}
+
+inline void Signature::mulVecMT(SignatureVec& sigVec, const SecretKeyVec& secVec, int threadN) _MCL_THROW
+{
+	size_t n = sigVec.size();
+	if (n == 0 || n != secVec.size()) {
+		throw std::runtime_error("bad length");
+	}
+	blsSignatureMulVecMT(&self_, &sigVec[0].self_, &secVec[0].self_, n, threadN);
+}
+
 inline void SecretKey::setHashOf(const char *cbuf, size_t bufSize) _MCL_THROW
 {
 	int r = blsHashToSecretKey(&self_, cbuf, bufSize);
@@ -1457,6 +1457,38 @@ SWIGEXPORT void JNICALL Java_com_herumi_bls_BlsJNI_PublicKey_1recover(JNIEnv *je
 }
 
 
+SWIGEXPORT void JNICALL Java_com_herumi_bls_BlsJNI_PublicKey_1mulVecMT(JNIEnv *jenv, jclass jcls, jlong jarg1, jobject jarg1_, jlong jarg2, jobject jarg2_, jlong jarg3, jobject jarg3_, jint jarg4) {
+  PublicKey *arg1 = (PublicKey *) 0 ;
+  PublicKeyVec *arg2 = 0 ;
+  SecretKeyVec *arg3 = 0 ;
+  int arg4 ;
+  
+  (void)jenv;
+  (void)jcls;
+  (void)jarg1_;
+  (void)jarg2_;
+  (void)jarg3_;
+  arg1 = *(PublicKey **)&jarg1; 
+  arg2 = *(PublicKeyVec **)&jarg2;
+  if (!arg2) {
+    SWIG_JavaThrowException(jenv, SWIG_JavaNullPointerException, "PublicKeyVec & is null");
+    return ;
+  } 
+  arg3 = *(SecretKeyVec **)&jarg3;
+  if (!arg3) {
+    SWIG_JavaThrowException(jenv, SWIG_JavaNullPointerException, "SecretKeyVec const & is null");
+    return ;
+  } 
+  arg4 = (int)jarg4; 
+  try {
+    (arg1)->mulVecMT(*arg2,(SecretKeyVec const &)*arg3,arg4);
+  } catch(std::exception &_e) {
+    SWIG_JavaThrowException(jenv, SWIG_JavaRuntimeException, (&_e)->what());
+    return ;
+  }
+}
+
+
 SWIGEXPORT void JNICALL Java_com_herumi_bls_BlsJNI_delete_1PublicKey(JNIEnv *jenv, jclass jcls, jlong jarg1) {
   PublicKey *arg1 = (PublicKey *) 0 ;
   
@@ -1812,6 +1844,38 @@ SWIGEXPORT void JNICALL Java_com_herumi_bls_BlsJNI_Signature_1recover(JNIEnv *je
 }
 
 
+SWIGEXPORT void JNICALL Java_com_herumi_bls_BlsJNI_Signature_1mulVecMT(JNIEnv *jenv, jclass jcls, jlong jarg1, jobject jarg1_, jlong jarg2, jobject jarg2_, jlong jarg3, jobject jarg3_, jint jarg4) {
+  Signature *arg1 = (Signature *) 0 ;
+  SignatureVec *arg2 = 0 ;
+  SecretKeyVec *arg3 = 0 ;
+  int arg4 ;
+  
+  (void)jenv;
+  (void)jcls;
+  (void)jarg1_;
+  (void)jarg2_;
+  (void)jarg3_;
+  arg1 = *(Signature **)&jarg1; 
+  arg2 = *(SignatureVec **)&jarg2;
+  if (!arg2) {
+    SWIG_JavaThrowException(jenv, SWIG_JavaNullPointerException, "SignatureVec & is null");
+    return ;
+  } 
+  arg3 = *(SecretKeyVec **)&jarg3;
+  if (!arg3) {
+    SWIG_JavaThrowException(jenv, SWIG_JavaNullPointerException, "SecretKeyVec const & is null");
+    return ;
+  } 
+  arg4 = (int)jarg4; 
+  try {
+    (arg1)->mulVecMT(*arg2,(SecretKeyVec const &)*arg3,arg4);
+  } catch(std::exception &_e) {
+    SWIG_JavaThrowException(jenv, SWIG_JavaRuntimeException, (&_e)->what());
+    return ;
+  }
+}
+
+
 SWIGEXPORT void JNICALL Java_com_herumi_bls_BlsJNI_Signature_1setHashOf(JNIEnv *jenv, jclass jcls, jlong jarg1, jobject jarg1_, jbyteArray jarg2) {
   Signature *arg1 = (Signature *) 0 ;
   char *arg2 = (char *) 0 ;
@@ -57,6 +57,7 @@ public class BlsJNI {
   public final static native void PublicKey_neg(long jarg1, PublicKey jarg1_);
   public final static native void PublicKey_share(long jarg1, PublicKey jarg1_, long jarg2, PublicKeyVec jarg2_, long jarg3, SecretKey jarg3_);
   public final static native void PublicKey_recover(long jarg1, PublicKey jarg1_, long jarg2, PublicKeyVec jarg2_, long jarg3, SecretKeyVec jarg3_);
+  public final static native void PublicKey_mulVecMT(long jarg1, PublicKey jarg1_, long jarg2, PublicKeyVec jarg2_, long jarg3, SecretKeyVec jarg3_, int jarg4);
   public final static native void delete_PublicKey(long jarg1);
   public final static native long new_Signature__SWIG_0();
   public final static native long new_Signature__SWIG_1(long jarg1, Signature jarg1_);
@@ -74,6 +75,7 @@ public class BlsJNI {
   public final static native boolean Signature_verify(long jarg1, Signature jarg1_, long jarg2, PublicKey jarg2_, byte[] jarg3);
   public final static native boolean Signature_verifyHash(long jarg1, Signature jarg1_, long jarg2, PublicKey jarg2_, byte[] jarg3);
   public final static native void Signature_recover(long jarg1, Signature jarg1_, long jarg2, SignatureVec jarg2_, long jarg3, SecretKeyVec jarg3_);
+  public final static native void Signature_mulVecMT(long jarg1, Signature jarg1_, long jarg2, SignatureVec jarg2_, long jarg3, SecretKeyVec jarg3_, int jarg4);
   public final static native void Signature_setHashOf(long jarg1, Signature jarg1_, byte[] jarg2);
   public final static native void Signature_aggregate(long jarg1, Signature jarg1_, long jarg2, SignatureVec jarg2_);
   public final static native boolean Signature_fastAggregateVerify(long jarg1, Signature jarg1_, long jarg2, PublicKeyVec jarg2_, byte[] jarg3);
@@ -106,4 +106,8 @@ public class PublicKey {
     BlsJNI.PublicKey_recover(swigCPtr, this, PublicKeyVec.getCPtr(secVec), secVec, SecretKeyVec.getCPtr(idVec), idVec);
   }
 
+  public void mulVecMT(PublicKeyVec pubVec, SecretKeyVec secVec, int threadN) {
+    BlsJNI.PublicKey_mulVecMT(swigCPtr, this, PublicKeyVec.getCPtr(pubVec), pubVec, SecretKeyVec.getCPtr(secVec), secVec, threadN);
+  }
+
 }
@@ -110,6 +110,10 @@ public class Signature {
     BlsJNI.Signature_recover(swigCPtr, this, SignatureVec.getCPtr(sigVec), sigVec, SecretKeyVec.getCPtr(idVec), idVec);
   }
 
+  public void mulVecMT(SignatureVec sigVec, SecretKeyVec secVec, int threadN) {
+    BlsJNI.Signature_mulVecMT(swigCPtr, this, SignatureVec.getCPtr(sigVec), sigVec, SecretKeyVec.getCPtr(secVec), secVec, threadN);
+  }
+
   public void setHashOf(byte[] cbuf) {
     BlsJNI.Signature_setHashOf(swigCPtr, this, cbuf);
   }
@@ -90,6 +90,11 @@ pub const PublicKey = struct {
     pub fn add(self: *PublicKey, rhs: *const PublicKey) void {
         bls.blsPublicKeyAdd(&self.v_, &rhs.v_);
     }
+    // self = sum of pubVec[i] * secVec[i] with threadN threads (pubVec may be normalized)
+    pub fn mulVecMT(self: *PublicKey, pubVec: []PublicKey, secVec: []const SecretKey, threadN: c_int) !void {
+        if (pubVec.len == 0 or pubVec.len != secVec.len) return Error.InvalidLength;
+        bls.blsPublicKeyMulVecMT(&self.v_, &pubVec[0].v_, &secVec[0].v_, pubVec.len, threadN);
+    }
 };
 
 pub const Signature = struct {
@@ -107,6 +112,11 @@ pub const Signature = struct {
     pub fn add(self: *Signature, rhs: *const Signature) void {
         bls.blsSignatureAdd(&self.v_, &rhs.v_);
     }
+    // self = sum of sigVec[i] * secVec[i] with threadN threads (sigVec may be normalized)
+    pub fn mulVecMT(self: *Signature, sigVec: []Signature, secVec: []const SecretKey, threadN: c_int) !void {
+        if (sigVec.len == 0 or sigVec.len != secVec.len) return Error.InvalidLength;
+        bls.blsSignatureMulVecMT(&self.v_, &sigVec[0].v_, &secVec[0].v_, sigVec.len, threadN);
+    }
     pub fn fastAggregateVerify(self: *const Signature, pubVec: []const PublicKey, msg: []const u8) !bool {
         if (pubVec.len == 0) return Error.InvalidLength;
         return bls.blsFastAggregateVerify(&self.v_, &pubVec[0].v_, pubVec.len, msg.ptr, msg.len) == 1;
@@ -16,6 +16,7 @@ test "all" {
     try std.testing.expect(try areAllMessageDifferentTest(255));
     try std.testing.expect(try areAllMessageDifferentTest(256));
     try std.testing.expect(!try areAllMessageDifferentTest(257)); // contains the same msg
+    try std.testing.expect(try mulVecMTTest(600));
 }
 
 fn signAndVerifyTest(msg1: []const u8, msg2: []const u8) bool {
@@ -36,3 +37,22 @@ fn areAllMessageDifferentTest(n: usize) !bool {
     }
     return bls.areAllMessageDifferent(msgVec[0..n]);
 }
+
+fn mulVecMTTest(comptime n: usize) !bool {
+    const msg = "bls zig test";
+    var pkVec: [n]bls.PublicKey = undefined;
+    var sigVec: [n]bls.Signature = undefined;
+    var coeffVec: [n]bls.SecretKey = undefined;
+    for (0..n) |i| {
+        var sk: bls.SecretKey = undefined;
+        sk.setByCSPRNG();
+        sk.getPublicKey(&pkVec[i]);
+        sk.sign(&sigVec[i], msg);
+        coeffVec[i].setByCSPRNG();
+    }
+    var pk: bls.PublicKey = undefined;
+    var sig: bls.Signature = undefined;
+    try pk.mulVecMT(&pkVec, &coeffVec, 4);
+    try sig.mulVecMT(&sigVec, &coeffVec, 4);
+    return pk.verify(&sig, msg);
+}
@@ -88,6 +88,16 @@ MCL_DLL_API void blsSetETHserialization(int ETHserialization);
 */
 MCL_DLL_API int blsSetMapToMode(int mode);
 
+/*
+	set the domain separation tag of hash-to-curve for the signature
+	(G2 if BLS_ETH is defined else G1)
+	same as mclBnG2_setDst (mclBnG1_setDst for non-ETH) ; the hash of the signature always follows the DST and the map-to mode of mcl
+	the batch functions hash many messages at once by expand_message_xmd with the midstate of DST (BLS_ETH on BLS12-381)
+	while mcl keeps the DST and the map-to mode given by blsSetDst and blsSetMapToMode
+	return 0 if success else -1
+*/
+MCL_DLL_API int blsSetDst(const char *dst, mclSize dstSize);
+
 MCL_DLL_API void blsIdSetInt(blsId *id, int x);
 
 // sec = buf & (1 << bitLen(r)) - 1
@@ -102,6 +112,8 @@ MCL_DLL_API void blsGetPublicKey(blsPublicKey *pub, const blsSecretKey *sec);
 
 // calculate the has of m and sign the hash
 MCL_DLL_API void blsSign(blsSignature *sig, const blsSecretKey *sec, const void *m, mclSize size);
+// sig = sec * Hm where Hm is made by blsHashToSignature
+MCL_DLL_API void blsSignHashedPoint(blsSignature *sig, const blsSecretKey *sec, const blsSignature *Hm);
 
 // return 1 if valid else 0
 // @remark return 0 if pub is zero for BLS_ETH
@@ -133,6 +145,15 @@ MCL_DLL_API void blsMultiVerifySub(mclBnGT *e, blsSignature *aggSig, blsSignatur
 */
 MCL_DLL_API int blsMultiVerifyFinal(const mclBnGT *e, const blsSignature *aggSig);
 
+/*
+	variable-length message version of blsMultiVerify and blsMultiVerifySub
+	the i-th message is msgVec[msgOffsetVec[i], msgOffsetVec[i + 1]) for i = 0, ..., n-1
+	@param msgOffsetVec [in] (n + 1) array of byte offsets into msgVec
+	@note for only BLS_ETH
+*/
+MCL_DLL_API int blsMultiVerifyVarLen(blsSignature *sigVec, const blsPublicKey *pubVec, const void *msgVec, const mclSize *msgOffsetVec, const void *randVec, mclSize randSize, mclSize n, int threadN);
+MCL_DLL_API void blsMultiVerifySubVarLen(mclBnGT *e, blsSignature *aggSig, blsSignature *sigVec, const blsPublicKey *pubVec, const char *msgVec, const mclSize *msgOffsetVec, const char *randVec, mclSize randSize, mclSize n);
+
 // aggSig = sum of sigVec[0..n]
 MCL_DLL_API void blsAggregateSignature(blsSignature *aggSig, const blsSignature *sigVec, mclSize n);
 
@@ -145,6 +166,30 @@ MCL_DLL_API int blsFastAggregateVerify(const blsSignature *sig, const blsPublicK
 	@note CHECK that sig has the valid order, all msg are different each other before calling this
 */
 MCL_DLL_API int blsAggregateVerifyNoCheck(const blsSignature *sig, const blsPublicKey *pubVec, const void *msgVec, mclSize msgSize, mclSize n);
+/*
+	variable-length message version of blsAggregateVerifyNoCheck
+	the i-th message is msgVec[msgOffsetVec[i], msgOffsetVec[i + 1]) for i = 0, ..., n-1
+	@param msgOffsetVec [in] (n + 1) array of byte offsets into msgVec
+*/
+MCL_DLL_API int blsAggregateVerifyNoCheckVarLen(const blsSignature *sig, const blsPublicKey *pubVec, const void *msgVec, const mclSize *msgOffsetVec, mclSize n);
+/*
+	same as blsAggregateVerifyNoCheck but return 0 if some msg are the same
+	the check uses no heap and runs in parallel with hashing if n is large
+	@note CHECK that sig has the valid order before calling this
+*/
+MCL_DLL_API int blsAggregateVerify(const blsSignature *sig, const blsPublicKey *pubVec, const void *msgVec, mclSize msgSize, mclSize n);
+// variable-length message version of blsAggregateVerify
+MCL_DLL_API int blsAggregateVerifyVarLen(const blsSignature *sig, const blsPublicKey *pubVec, const void *msgVec, const mclSize *msgOffsetVec, mclSize n);
+/*
+	return 1 if all msg of msgSize byte in msgVec are different from each other else 0
+	@param buf [in] scratch area of bufSize byte (may be NULL)
+	@param threadN [in] the number of threads (ignored if not supported)
+	@note buf is used for the sorted fingerprints of (8 * n) byte
+	@note no heap is used ; if buf is NULL or too small, large n takes several passes over the messages
+*/
+MCL_DLL_API int blsAreAllMsgDifferent(const void *msgVec, mclSize msgSize, mclSize n, void *buf, mclSize bufSize, int threadN);
+// variable-length message version of blsAreAllMsgDifferent
+MCL_DLL_API int blsAreAllMsgDifferentVarLen(const void *msgVec, const mclSize *msgOffsetVec, mclSize n, void *buf, mclSize bufSize, int threadN);
 
 // return written byte size if success else 0
 MCL_DLL_API mclSize blsIdSerialize(void *buf, mclSize maxBufSize, const blsId *id);
@@ -261,6 +306,31 @@ MCL_DLL_API void blsSignatureMul(blsSignature *y, const blsSecretKey *x);
 // x may be normalized, so it is not a const pointer
 MCL_DLL_API void blsPublicKeyMulVec(blsPublicKey *z, blsPublicKey *x, const blsSecretKey *y, mclSize n);
 MCL_DLL_API void blsSignatureMulVec(blsSignature *z, blsSignature *x, const blsSecretKey *y, mclSize n);
+/*
+	multi-threaded version of blsPublicKeyMulVec and blsSignatureMulVec
+	@param threadN [in] the number of threads (ignored if not supported)
+*/
+MCL_DLL_API void blsPublicKeyMulVecMT(blsPublicKey *z, blsPublicKey *x, const blsSecretKey *y, mclSize n, int threadN);
+MCL_DLL_API void blsSignatureMulVecMT(blsSignature *z, blsSignature *x, const blsSecretKey *y, mclSize n, int threadN);
+/*
+	multi-threaded version of blsPublicKeyRecover and blsSignatureRecover
+	@param threadN [in] the number of threads (ignored if not supported)
+*/
+MCL_DLL_API int blsPublicKeyRecoverMT(blsPublicKey *pub, const blsPublicKey *pubVec, const blsId *idVec, mclSize n, int threadN);
+MCL_DLL_API int blsSignatureRecoverMT(blsSignature *sig, const blsSignature *sigVec, const blsId *idVec, mclSize n, int threadN);
+/*
+	sigVec[i] = sign of msg by secVec[i] for i = 0, ..., n-1
+	msg is hashed once and the signatures are normalized (cheap to serialize)
+	@param threadN [in] the number of threads (ignored if not supported)
+*/
+MCL_DLL_API void blsSignManyKeys(blsSignature *sigVec, const blsSecretKey *secVec, mclSize n, const void *msg, mclSize msgSize, int threadN);
+/*
+	sigVec[i] = sign of the i-th message by sec for i = 0, ..., n-1
+	the i-th message is msgVec[msgOffsetVec[i], msgOffsetVec[i + 1])
+	the messages are hashed in batches and the signatures are normalized
+	@param threadN [in] the number of threads (ignored if not supported)
+*/
+MCL_DLL_API void blsSignVec(blsSignature *sigVec, const blsSecretKey *sec, const void *msgVec, const mclSize *msgOffsetVec, mclSize n, int threadN);
 
 // not thread safe version (old blsInit)
 MCL_DLL_API int blsInitNotThreadSafe(int curve, int compiledTimeVar);
@@ -287,6 +357,20 @@ MCL_DLL_API int blsGetFrByteSize(void);
 MCL_DLL_API void blsGetGeneratorOfPublicKey(blsPublicKey *pub);
 // set a generator of PublicKey
 MCL_DLL_API int blsSetGeneratorOfPublicKey(const blsPublicKey *pub);
+/*
+	make a precomputed table of window w for the generator of PublicKey
+	blsGetPublicKey and blsGetPop use it by a constant-time lookup
+	a larger w is faster and takes ceil(bitSize(r) / w) 2^(w - 1) points
+	the table is remade by blsInit and blsSetGeneratorOfPublicKey
+	w = 0 ; disable the table (default)
+	return 0 if success (2 <= w <= blsGetMaxGeneratorTableWindow()) else -1
+	@note not thread safe
+*/
+MCL_DLL_API int blsSetGeneratorTableWindow(int w);
+// return the window of the table (0 if disabled)
+MCL_DLL_API int blsGetGeneratorTableWindow(void);
+// return the maximum window (BLS_FIXED_BASE_MAX_WINDOW)
+MCL_DLL_API int blsGetMaxGeneratorTableWindow(void);
 
 // return 0 if success
 MCL_DLL_API int blsIdSetDecStr(blsId *id, const char *buf, mclSize bufSize);
@@ -323,6 +407,15 @@ MCL_DLL_API void blsSetRandFunc(void *self, unsigned int (*readFunc)(void *self,
 MCL_DLL_API void blsGetPop(blsSignature *sig, const blsSecretKey *sec);
 
 MCL_DLL_API int blsVerifyPop(const blsSignature *sig, const blsPublicKey *pub);
+
+/*
+	verify the PoPs popVec[i] of pubVec[i] for i = 0, ..., n-1 at once
+	by the random linear combination with randVec[randSize * i, randSize * (i + 1))
+	okVec[i] = 1 if popVec[i] is valid else 0 ; the failed ones are found by bisection
+	return the number of valid PoPs (n if all of them are valid)
+	@note randVec should be made by CSPRNG ; randSize = 8 is enough for the soundness of 2^-64
+*/
+MCL_DLL_API mclSize blsVerifyPopVec(uint8_t *okVec, const blsSignature *popVec, const blsPublicKey *pubVec, mclSize n, const void *randVec, mclSize randSize);
 //////////////////////////////////////////////////////////////////////////
 // the following apis will be removed
 
@@ -369,6 +462,231 @@ MCL_DLL_API void blsDHKeyExchange(blsPublicKey *out, const blsSecretKey *sec, co
 MCL_DLL_API void blsMultiAggregateSignature(blsSignature *aggSig, blsSignature *sigVec, blsPublicKey *pubVec, mclSize n);
 // aggPub = sum pubVec[i] t_i where (t_1, ..., t_n) = H({pubVec})
 MCL_DLL_API void blsMultiAggregatePublicKey(blsPublicKey *aggPub, blsPublicKey *pubVec, mclSize n);
+
+/*
+	precomputed data of blsMultiAggregate* for a fixed pubVec
+	aggPub ; the same value as blsMultiAggregatePublicKey
+	coeffVec ; (t_1, ..., t_n) = H({pubVec}) in the area given by the caller
+*/
+typedef struct {
+	blsPublicKey aggPub;
+	blsSecretKey *coeffVec;
+	mclSize n;
+} blsMultiAggregateContext;
+/*
+	set ctx for pubVec
+	@param coeffVec [out] n array which must be alive while ctx is used
+*/
+MCL_DLL_API void blsMultiAggregateContextInit(blsMultiAggregateContext *ctx, blsSecretKey *coeffVec, blsPublicKey *pubVec, mclSize n);
+// aggSig = sum sigVec[i] t_i, which is the same as blsMultiAggregateSignature for pubVec of ctx
+MCL_DLL_API void blsMultiAggregateSignatureWithContext(blsSignature *aggSig, blsSignature *sigVec, const blsMultiAggregateContext *ctx);
+
+/*
+	generate the keys of the indices begin, ..., begin + n - 1 deterministically from seed
+	secVec[i] = SHA-256 based DRBG(seed, begin + i) mod r
+	pubVec[i] = the public key of secVec[i] (normalized)
+	call it with begin = 0, m, 2m, ... to generate many keys by chunks of m keys
+	@param threadN [in] the number of threads (ignored if not supported)
+	@note for tests and simulations ; use blsSecretKeySetByCSPRNG for real keys
+	@note it uses the table of blsSetGeneratorTableWindow if it is enabled ; enable it before for many keys
+*/
+MCL_DLL_API void blsKeyGenVec(blsSecretKey *secVec, blsPublicKey *pubVec, mclSize n, const void *seed, mclSize seedSize, mclSize begin, int threadN);
+
+/*
+	blsContext has its own settings instead of the global ones
+	- the generator of PublicKey (and its precomputed value for non-ETH)
+	- DST of hash-to-curve if blsContextSetDst is called (BLS_ETH)
+	the functions *WithContext do not read the generator set by blsSetGeneratorOfPublicKey
+	but they hash messages with the DST and the map-to mode of mcl (blsSetDst, blsSetMapToMode) unless ctx has DST
+	and ctx with DST still needs the map-to mode of hash-to-curve
+	they are thread safe while ctx and these settings are not modified
+	the other batch functions such as blsMultiVerify, blsVerifyAggregatedHashes, blsVerifyPopVec and blsVerifySameMessageVec
+	have no context version and use the global settings
+	@note the curve is the one set by blsInit because mcl keeps it globally
+	@note allocate blsGetContextByteSize() bytes aligned to 8 bytes for ctx
+*/
+typedef struct blsContext blsContext;
+MCL_DLL_API mclSize blsGetContextByteSize(void);
+// init ctx by the current global settings
+MCL_DLL_API void blsContextInit(blsContext *ctx);
+// return 0 if success
+MCL_DLL_API int blsContextSetGeneratorOfPublicKey(blsContext *ctx, const blsPublicKey *pub);
+MCL_DLL_API void blsContextGetGeneratorOfPublicKey(blsPublicKey *pub, const blsContext *ctx);
+/*
+	set DST of hash-to-curve for ctx
+	the messages are hashed by expand_message_xmd with the midstate of DST cached in ctx
+	as the global settings do (see blsSetDst) but regardless of the DST of mcl
+	return 0 if success
+	return -1 if not BLS_ETH or the map-to mode is not hash-to-curve on BLS12-381
+	@note keep the map-to mode hash-to-curve while ctx is used
+*/
+MCL_DLL_API int blsContextSetDst(blsContext *ctx, const char *dst, mclSize dstSize);
+// same as blsGetPublicKey, blsSign, ... with the settings of ctx
+MCL_DLL_API void blsGetPublicKeyWithContext(blsPublicKey *pub, const blsSecretKey *sec, const blsContext *ctx);
+MCL_DLL_API void blsSignWithContext(blsSignature *sig, const blsSecretKey *sec, const void *m, mclSize size, const blsContext *ctx);
+MCL_DLL_API int blsVerifyWithContext(const blsSignature *sig, const blsPublicKey *pub, const void *m, mclSize size, const blsContext *ctx);
+MCL_DLL_API int blsFastAggregateVerifyWithContext(const blsSignature *sig, const blsPublicKey *pubVec, mclSize n, const void *msg, mclSize msgSize, const blsContext *ctx);
+// BLS_ETH only
+MCL_DLL_API int blsAggregateVerifyWithContext(const blsSignature *sig, const blsPublicKey *pubVec, const void *msgVec, mclSize msgSize, mclSize n, const blsContext *ctx);
+MCL_DLL_API int blsAggregateVerifyNoCheckWithContext(const blsSignature *sig, const blsPublicKey *pubVec, const void *msgVec, mclSize msgSize, mclSize n, const blsContext *ctx);
+
+/*
+	verify the shares secVec[i] for id from n dealers at once (Feldman VSS)
+	the commitments of the i-th dealer are mpkVec[k * i, k * (i + 1)) (mpk of blsPublicKeyShare)
+	check secVec[i] P == sum_{j=0}^{k-1} mpkVec[k * i + j] id^j for all i
+	by the random linear combination with randVec[randSize * i, randSize * (i + 1)) and multi-scalar multiplications
+	okVec[i] = 1 if the share of the i-th dealer is valid else 0 ; the failed ones are found by bisection
+	return the number of valid shares
+	@param threadN [in] the number of threads (ignored if not supported)
+	@note randVec should be made by CSPRNG ; randSize = 8 is enough for the soundness of 2^-64
+*/
+MCL_DLL_API mclSize blsVerifySecretKeyShareVec(uint8_t *okVec, const blsSecretKey *secVec, const blsPublicKey *mpkVec, mclSize k, const blsId *id, mclSize n, const void *randVec, mclSize randSize, int threadN);
+
+/*
+	same as blsSecretKeyShare(&secVec[i], msk, k, &idVec[i]) for i = 0, ..., n-1
+	same as blsPublicKeyShare(&pubVec[i], mpk, k, &idVec[i]) for i = 0, ..., n-1
+	@param threadN [in] the number of threads (ignored if not supported)
+	return 0 if success
+*/
+MCL_DLL_API int blsSecretKeyShareVec(blsSecretKey *secVec, const blsSecretKey *msk, mclSize k, const blsId *idVec, mclSize n, int threadN);
+MCL_DLL_API int blsPublicKeyShareVec(blsPublicKey *pubVec, const blsPublicKey *mpk, mclSize k, const blsId *idVec, mclSize n, int threadN);
+
+/*
+	coeffVec[i] = the Lagrange coefficient at 0 for idVec[i] in idVec[0, n)
+	blsSignatureRecover(sig, sigVec, idVec, n) = sum_i coeffVec[i] sigVec[i]
+	the ids idVec[i] = id + i (e.g. 1, 2, ..., n by blsIdSetInt) are detected
+	and their coefficients are computed by O(n) multiplications with the factorials
+	return 0 if success
+	return -1 if n = 0 or idVec has zero or the same ids
+*/
+MCL_DLL_API int blsGetLagrangeCoefficient(blsSecretKey *coeffVec, const blsId *idVec, mclSize n);
+
+/*
+	precomputed data of blsSecretKeyRecover, blsPublicKeyRecover, blsSignatureRecover for a fixed idVec
+	coeffVec ; the Lagrange coefficients at 0 for idVec in the area given by the caller
+*/
+typedef struct {
+	blsSecretKey *coeffVec;
+	mclSize n;
+} blsRecoveryPlan;
+/*
+	set plan for idVec
+	@param coeffVec [out] n array which must be alive while plan is used
+	return 0 if success
+	return -1 if n = 0 or idVec has zero or the same ids
+*/
+MCL_DLL_API int blsRecoveryPlanInit(blsRecoveryPlan *plan, blsSecretKey *coeffVec, const blsId *idVec, mclSize n);
+/*
+	same as blsSecretKeyRecover, blsPublicKeyRecover, blsSignatureRecover for idVec of plan
+	the i-th element of secVec, pubVec, sigVec is for idVec[i]
+	return 0 if success
+*/
+MCL_DLL_API int blsSecretKeyRecoverWithPlan(blsSecretKey *sec, const blsSecretKey *secVec, const blsRecoveryPlan *plan);
+MCL_DLL_API int blsPublicKeyRecoverWithPlan(blsPublicKey *pub, blsPublicKey *pubVec, const blsRecoveryPlan *plan);
+MCL_DLL_API int blsSignatureRecoverWithPlan(blsSignature *sig, blsSignature *sigVec, const blsRecoveryPlan *plan);
+/*
+	recover sig of msg from n partial signatures sigVec for idVec with the threshold k
+	pubVec[i] ; the public key share of idVec[i]
+	mpk ; the master public key (mpk[0] of blsPublicKeyShare)
+	1. recover sig from the first k shares and verify it by mpk ; one pairing check
+	2. if it fails, verify all shares by the random linear combination with randVec[randSize * i, randSize * (i + 1))
+	   find the invalid ones by bisection and recover sig from the first k valid shares
+	okVec[i] = 1 if sigVec[i] is verified, 0 if it is invalid
+	okVec[i] = 2 for all i if the step 1 succeeds because the shares are not verified one by one
+	the shares of zero or the same ids are skipped at the recovery of the step 2
+	return 0 if sig is valid
+	return -1 if there are fewer than k valid shares of nonzero and distinct ids
+	@note randVec should be made by CSPRNG ; randSize = 8 is enough for the soundness of 2^-64
+*/
+MCL_DLL_API int blsSignatureRecoverRobust(blsSignature *sig, uint8_t *okVec, const blsSignature *sigVec, const blsPublicKey *pubVec, const blsId *idVec, mclSize n, mclSize k, const blsPublicKey *mpk, const void *msg, mclSize msgSize, const void *randVec, mclSize randSize);
+/*
+	verify the signatures sigVec[i] of the same msg by pubVec[i] for i = 0, ..., n-1 at once
+	msg is hashed once and e(sum_i r_i sigVec[i], Q) = e(H(msg), sum_i r_i pubVec[i]) is checked
+	by two multi-scalar multiplications with r_i = randVec[randSize * i, randSize * (i + 1)) and one two-pairing product
+	okVec[i] = 1 if sigVec[i] is valid else 0 ; the failed ones are found by bisection
+	return the number of valid signatures
+	@param threadN [in] the number of threads (ignored if not supported)
+	@note randVec should be made by CSPRNG ; randSize = 8 is enough for the soundness of 2^-64
+*/
+MCL_DLL_API mclSize blsVerifySameMessageVec(uint8_t *okVec, const blsSignature *sigVec, const blsPublicKey *pubVec, mclSize n, const void *msg, mclSize msgSize, const void *randVec, mclSize randSize, int threadN);
+/*
+	counters and latency histograms of the hot paths
+	they are collected if the library is built with BLS_USE_STATS (`make BLS_STATS=1`)
+	count ; the number of calls
+	itemN ; the number of the items such as the pairs of a Miller loop and the points of a multi-scalar multiplication
+	totalNs ; the total time in nanoseconds
+	hist[i] ; the number of the calls taking [2^i, 2^(i+1)) ns (hist[BLS_STATS_BUCKET_N - 1] has no upper bound)
+*/
+#define BLS_STAT_MILLER_LOOP 0
+#define BLS_STAT_FINAL_EXP 1
+#define BLS_STAT_HASH_TO_CURVE 2
+#define BLS_STAT_SUBGROUP_CHECK 3 // blsPublicKeyIsValidOrder and blsSignatureIsValidOrder
+#define BLS_STAT_DESERIALIZE 4 // blsPublicKeyDeserialize and blsSignatureDeserialize (including the subgroup check by default)
+#define BLS_STAT_MUL 5
+#define BLS_STAT_MUL_VEC 6
+#define BLS_STAT_N 7
+#define BLS_STATS_BUCKET_N 32
+
+typedef struct {
+	uint64_t count;
+	uint64_t itemN;
+	uint64_t totalNs;
+	uint64_t hist[BLS_STATS_BUCKET_N];
+} blsStatEntry;
+
+typedef struct {
+	blsStatEntry v[BLS_STAT_N]; // v[BLS_STAT_*]
+} blsStats;
+
+/*
+	set the sum of the counters of all threads to stats
+	return 0 if success
+	return -1 (and clear stats) if the library is built without BLS_USE_STATS
+*/
+MCL_DLL_API int blsGetStats(blsStats *stats);
+// clear the counters
+MCL_DLL_API void blsResetStats(void);
+// return the name of BLS_STAT_* such as "miller_loop" or NULL
+MCL_DLL_API const char *blsGetStatName(int kind);
+/*
+	write stats to buf in the text format of Prometheus (about 14KiB)
+	return strlen(buf) if success else 0
+*/
+MCL_DLL_API mclSize blsStatsToText(char *buf, mclSize maxBufSize, const blsStats *stats);
+/*
+	the phases of the batch verification reported to blsTraceCallback
+*/
+#define BLS_PHASE_BATCH 0 // a call of blsMultiVerify, blsAggregateVerify, blsVerifySameMessageVec, etc.
+#define BLS_PHASE_WORKER 1 // the part of a batch done by one thread
+#define BLS_PHASE_HASH 2 // hash-to-curve of the messages
+#define BLS_PHASE_MUL 3 // scalar multiplications by the random coefficients
+#define BLS_PHASE_MILLER_LOOP 4
+#define BLS_PHASE_FINAL_EXP 5
+#define BLS_PHASE_JOIN 6 // waiting for the threads
+#define BLS_PHASE_N 7
+
+/*
+	called at the beginning (isBegin = 1) and the end (isBegin = 0) of a phase
+	self ; the pointer given to blsSetTraceCallback
+	threadId ; a small id of the calling thread (0 if threads are not supported)
+	itemN ; the number of the signatures, messages or pairs of the phase
+	@note it is called from the threads made by the library, so it must be thread-safe
+*/
+typedef void (*blsTraceCallback)(void *self, int phase, int isBegin, int threadId, mclSize itemN);
+/*
+	register f to be called with self ; f = NULL disables tracing
+	it may be called while other threads are verifying ; a phase begun before the call ends with the old f
+	so keep self alive until such verifications return
+	return 0 if success
+*/
+MCL_DLL_API int blsSetTraceCallback(blsTraceCallback f, void *self);
+/*
+	disable tracing only if f and self are the current ones
+	return 0 if success else -1 (another callback is registered and kept)
+*/
+MCL_DLL_API int blsClearTraceCallback(blsTraceCallback f, void *self);
+// return the name of BLS_PHASE_* such as "miller_loop" or NULL
+MCL_DLL_API const char *blsGetTracePhaseName(int phase);
 #endif // BLS_MINIMUM_API
 
 #ifdef __cplusplus
@@ -0,0 +1,119 @@
+#pragma once
+/**
+	@file
+	@brief record the phases reported by blsSetTraceCallback as Chrome trace_event JSON
+	@author MITSUNARI Shigeo(@herumi)
+	@license modified new BSD license
+	http://opensource.org/licenses/BSD-3-Clause
+	open the output with chrome://tracing or https://ui.perfetto.dev
+	C++11 is required
+*/
+#include <bls/bls.h>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <stdio.h>
+
+namespace bls {
+
+/*
+	ChromeTraceRecorder rec;
+	rec.start();
+	blsMultiVerify(...);
+	rec.stop();
+	rec.save("trace.json");
+*/
+class ChromeTraceRecorder {
+	typedef std::chrono::steady_clock Clock;
+	struct Event {
+		int phase;
+		int isBegin;
+		int threadId;
+		mclSize itemN;
+		uint64_t ns; // from origin_
+	};
+	mutable std::mutex mutex_;
+	std::vector<Event> eventVec_;
+	Clock::time_point origin_;
+	bool started_;
+	static void callback(void *self, int phase, int isBegin, int threadId, mclSize itemN)
+	{
+		static_cast<ChromeTraceRecorder*>(self)->add(phase, isBegin, threadId, itemN);
+	}
+	void add(int phase, int isBegin, int threadId, mclSize itemN)
+	{
+		Event ev;
+		ev.phase = phase;
+		ev.isBegin = isBegin;
+		ev.threadId = threadId;
+		ev.itemN = itemN;
+		std::lock_guard<std::mutex> lk(mutex_);
+		ev.ns = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - origin_).count();
+		eventVec_.push_back(ev);
+	}
+	ChromeTraceRecorder(const ChromeTraceRecorder&);
+	void operator=(const ChromeTraceRecorder&);
+public:
+	ChromeTraceRecorder() : origin_(Clock::now()), started_(false) {}
+	~ChromeTraceRecorder() { stop(); }
+	// register this recorder to the library in place of the current callback
+	void start()
+	{
+		started_ = blsSetTraceCallback(callback, this) == 0;
+	}
+	// unregister this recorder if it is still the current callback
+	void stop()
+	{
+		if (!started_) return;
+		blsClearTraceCallback(callback, this);
+		started_ = false;
+	}
+	// remove the events and reset the origin of the time
+	void clear()
+	{
+		std::lock_guard<std::mutex> lk(mutex_);
+		eventVec_.clear();
+		origin_ = Clock::now();
+	}
+	size_t size() const
+	{
+		std::lock_guard<std::mutex> lk(mutex_);
+		return eventVec_.size();
+	}
+	/*
+		the JSON object format of trace_event
+		ts is in microseconds and the thread id of the library is used as tid
+	*/
+	std::string getJson() const
+	{
+		std::lock_guard<std::mutex> lk(mutex_);
+		std::string s = "{\"traceEvents\":[";
+		char buf[256];
+		for (size_t i = 0; i < eventVec_.size(); i++) {
+			const Event& ev = eventVec_[i];
+			const char *name = blsGetTracePhaseName(ev.phase);
+			snprintf(buf, sizeof(buf), "%s\n{\"name\":\"%s\",\"cat\":\"bls\",\"ph\":\"%c\",\"ts\":%llu.%03u,\"pid\":0,\"tid\":%d,\"args\":{\"itemN\":%llu}}",
+				i == 0 ? "" : ",",
+				name ? name : "unknown",
+				ev.isBegin ? 'B' : 'E',
+				(unsigned long long)(ev.ns / 1000), (unsigned int)(ev.ns % 1000),
+				ev.threadId,
+				(unsigned long long)ev.itemN);
+			s += buf;
+		}
+		s += "\n],\"displayTimeUnit\":\"ns\"}\n";
+		return s;
+	}
+	// return true if success
+	bool save(const char *path) const
+	{
+		const std::string s = getJson();
+		FILE *fp = fopen(path, "wb");
+		if (fp == 0) return false;
+		const bool ok = fwrite(s.data(), 1, s.size(), fp) == s.size();
+		return fclose(fp) == 0 && ok;
+	}
+};
+
+} // bls
@@ -7,9 +7,20 @@
 	http://opensource.org/licenses/BSD-3-Clause
 */
 #include <stdint.h>
-#include <set>
 #include <memory.h>
 
+/*
+	the number of the entries on the stack (8 bytes per entry)
+	more messages without a caller-supplied buffer are checked in several passes
+*/
+#ifndef BLS_MSG_CHECK_STACK_N
+	#if defined(__EMSCRIPTEN__) || defined(__wasm__)
+		#define BLS_MSG_CHECK_STACK_N 512
+	#else
+		#define BLS_MSG_CHECK_STACK_N 1024
+	#endif
+#endif
+
 namespace bls_util {
 
 const size_t MSG_SIZE = 32;
@@ -30,21 +41,394 @@ struct Msg {
 	}
 };
 
+/*
+	accessors of messages
+	FixedSizeMsg ; the i-th message is msgVec[msgSize * i, msgSize * (i + 1))
+	VarSizeMsgT ; the i-th message is msgVec[msgOffsetVec[i], msgOffsetVec[i + 1])
+	skip(n) returns the accessor whose 0-th message is the n-th message
+*/
+class FixedSizeMsg {
+	const char *msgVec_;
+	size_t msgSize_;
+public:
+	FixedSizeMsg(const void *msgVec, size_t msgSize) : msgVec_((const char*)msgVec), msgSize_(msgSize) {}
+	const char *get(size_t i) const { return &msgVec_[msgSize_ * i]; }
+	size_t getSize(size_t) const { return msgSize_; }
+	FixedSizeMsg skip(size_t n) const { return FixedSizeMsg(msgVec_ + msgSize_ * n, msgSize_); }
+};
+
+template<class Size = size_t>
+class VarSizeMsgT {
+	const char *msgVec_;
+	const Size *msgOffsetVec_;
+public:
+	VarSizeMsgT(const void *msgVec, const Size *msgOffsetVec) : msgVec_((const char*)msgVec), msgOffsetVec_(msgOffsetVec) {}
+	const char *get(size_t i) const { return &msgVec_[msgOffsetVec_[i]]; }
+	size_t getSize(size_t i) const { return msgOffsetVec_[i + 1] - msgOffsetVec_[i]; }
+	VarSizeMsgT skip(size_t n) const { return VarSizeMsgT(msgVec_, msgOffsetVec_ + n); }
+};
+
+/*
+	the key of getMsgFingerprint
+	blsInit sets a random one so that the fingerprints of messages can not be predicted
+*/
+struct MsgFpKey {
+	uint64_t k0;
+	uint64_t k1;
+};
+
+inline MsgFpKey& getMsgFpKey()
+{
+	static MsgFpKey key = { 0x0706050403020100ull, 0x0f0e0d0c0b0a0908ull };
+	return key;
+}
+
+// set the key before checking messages in other threads
+inline void setMsgFpKey(uint64_t k0, uint64_t k1)
+{
+	MsgFpKey& key = getMsgFpKey();
+	key.k0 = k0;
+	key.k1 = k1;
+}
+
+inline uint64_t rotl64(uint64_t x, int s)
+{
+	return (x << s) | (x >> (64 - s));
+}
+
+inline void sipRound(uint64_t& v0, uint64_t& v1, uint64_t& v2, uint64_t& v3)
+{
+	v0 += v1; v1 = rotl64(v1, 13); v1 ^= v0; v0 = rotl64(v0, 32);
+	v2 += v3; v3 = rotl64(v3, 16); v3 ^= v2;
+	v0 += v3; v3 = rotl64(v3, 21); v3 ^= v0;
+	v2 += v1; v1 = rotl64(v1, 17); v1 ^= v2; v2 = rotl64(v2, 32);
+}
+
+/*
+	64-bit fingerprint of the whole message
+	SipHash-2-4 keyed by getMsgFpKey() (the words are read in the native byte order)
+*/
+inline uint64_t getMsgFingerprint(const char *msg, size_t size)
+{
+	const MsgFpKey& key = getMsgFpKey();
+	uint64_t v0 = key.k0 ^ 0x736f6d6570736575ull;
+	uint64_t v1 = key.k1 ^ 0x646f72616e646f6dull;
+	uint64_t v2 = key.k0 ^ 0x6c7967656e657261ull;
+	uint64_t v3 = key.k1 ^ 0x7465646279746573ull;
+	uint64_t last = uint64_t(size) << 56;
+	while (size >= 8) {
+		uint64_t w;
+		memcpy(&w, msg, 8);
+		v3 ^= w;
+		sipRound(v0, v1, v2, v3);
+		sipRound(v0, v1, v2, v3);
+		v0 ^= w;
+		msg += 8;
+		size -= 8;
+	}
+	if (size > 0) {
+		uint64_t w = 0;
+		memcpy(&w, msg, size);
+		last |= w;
+	}
+	v3 ^= last;
+	sipRound(v0, v1, v2, v3);
+	sipRound(v0, v1, v2, v3);
+	v0 ^= last;
+	v2 ^= 0xff;
+	for (int i = 0; i < 4; i++) {
+		sipRound(v0, v1, v2, v3);
+	}
+	return v0 ^ v1 ^ v2 ^ v3;
+}
+
+// same as memcmp, which the freestanding builds (src/mylib.c) do not have
+inline int cmpMsgByte(const char *x, const char *y, size_t size)
+{
+	for (size_t i = 0; i < size; i++) {
+		const uint8_t a = uint8_t(x[i]);
+		const uint8_t b = uint8_t(y[i]);
+		if (a != b) return a < b ? -1 : 1;
+	}
+	return 0;
+}
+
+template<class Msgs>
+bool isEqualMsg(const Msgs& msgs, size_t i, size_t j)
+{
+	const size_t size = msgs.getSize(i);
+	return size == msgs.getSize(j) && cmpMsgByte(msgs.get(i), msgs.get(j), size) == 0;
+}
+
+template<class T, class Less>
+void siftDown(T *a, size_t i, size_t n, const Less& less)
+{
+	const T x = a[i];
+	for (;;) {
+		size_t c = i * 2 + 1;
+		if (c >= n) break;
+		if (c + 1 < n && less(a[c], a[c + 1])) c++;
+		if (!less(x, a[c])) break;
+		a[i] = a[c];
+		i = c;
+	}
+	a[i] = x;
+}
+
+// in-place O(n log n) sort without recursion and heap allocation
+template<class T, class Less>
+void heapSort(T *a, size_t n, const Less& less)
+{
+	if (n < 2) return;
+	for (size_t i = n / 2; i > 0; i--) {
+		siftDown(a, i - 1, n, less);
+	}
+	for (size_t i = n - 1; i > 0; i--) {
+		const T t = a[0];
+		a[0] = a[i];
+		a[i] = t;
+		siftDown(a, 0, i, less);
+	}
+}
+
+/*
+	the entry of the i-th message is (the upper 32 bits of its fingerprint) | i
+	sorting the entries gathers the messages whose fingerprints have the same upper bits
+*/
+inline uint32_t getMsgIdx(uint64_t e) { return uint32_t(e); }
+
+struct MsgEntryLess {
+	bool operator()(uint64_t a, uint64_t b) const { return a < b; }
+};
+
+// order of the contents of the messages
+template<class Msgs>
+class MsgContentLess {
+	Msgs msgs_;
+public:
+	explicit MsgContentLess(const Msgs& msgs) : msgs_(msgs) {}
+	bool operator()(uint64_t a, uint64_t b) const
+	{
+		const size_t aSize = msgs_.getSize(getMsgIdx(a));
+		const size_t bSize = msgs_.getSize(getMsgIdx(b));
+		if (aSize != bSize) return aSize < bSize;
+		return cmpMsgByte(msgs_.get(getMsgIdx(a)), msgs_.get(getMsgIdx(b)), aSize) < 0;
+	}
+};
+
+/*
+	set e[i] to the entry of the (offset + i)-th message for i in [0, n)
+	msgs is the accessor whose 0-th message is the offset-th one
+*/
+template<class Msgs>
+void setMsgEntryVec(uint64_t *e, const Msgs& msgs, size_t n, size_t offset)
+{
+	for (size_t i = 0; i < n; i++) {
+		const uint64_t fp = getMsgFingerprint(msgs.get(i), msgs.getSize(i));
+		e[i] = (fp & 0xffffffff00000000ull) | uint64_t(offset + i);
+	}
+}
+
+/*
+	return false if some of the messages of e[0, n) are the same
+	they have the same upper fingerprint, so are different only by accident
+	many of them are sorted by their contents to keep O(n log n) time
+*/
+template<class Msgs>
+bool checkMsgSameFp(const Msgs& msgs, uint64_t *e, size_t n)
+{
+	const size_t maxPairN = 8;
+	if (n <= maxPairN) {
+		for (size_t i = 0; i < n; i++) {
+			for (size_t j = i + 1; j < n; j++) {
+				if (isEqualMsg(msgs, getMsgIdx(e[i]), getMsgIdx(e[j]))) return false;
+			}
+		}
+		return true;
+	}
+	heapSort(e, n, MsgContentLess<Msgs>(msgs));
+	for (size_t i = 1; i < n; i++) {
+		if (isEqualMsg(msgs, getMsgIdx(e[i - 1]), getMsgIdx(e[i]))) return false;
+	}
+	return true;
+}
+
+// return false if some of the messages of e[0, n) are the same
+template<class Msgs>
+bool checkMsgEntry(const Msgs& msgs, uint64_t *e, size_t n)
+{
+	heapSort(e, n, MsgEntryLess());
+	size_t i = 0;
+	while (i < n) {
+		size_t j = i + 1;
+		while (j < n && (e[j] >> 32) == (e[i] >> 32)) j++;
+		if (j - i > 1 && !checkMsgSameFp(msgs, e + i, j - i)) return false;
+		i = j;
+	}
+	return true;
+}
+
+const size_t msgBucketN = 256;
+
+/*
+	arrange e[0, n) in place so that e[pos[b], pos[b + 1]) have the top byte b
+	the buckets can be checked independently
+*/
+inline void distributeMsgEntry(uint64_t *e, size_t n, size_t pos[msgBucketN + 1])
+{
+	size_t next[msgBucketN];
+	memset(pos, 0, sizeof(size_t) * (msgBucketN + 1));
+	for (size_t i = 0; i < n; i++) {
+		pos[(e[i] >> 56) + 1]++;
+	}
+	for (size_t b = 0; b < msgBucketN; b++) {
+		pos[b + 1] += pos[b];
+		next[b] = pos[b];
+	}
+	for (size_t b = 0; b < msgBucketN; b++) {
+		while (next[b] < pos[b + 1]) {
+			uint64_t x = e[next[b]];
+			size_t c = size_t(x >> 56);
+			while (c != b) {
+				const uint64_t t = e[next[c]];
+				e[next[c]++] = x;
+				x = t;
+				c = size_t(x >> 56);
+			}
+			e[next[b]++] = x;
+		}
+	}
+}
+
+// check the buckets in [begin, end) made by distributeMsgEntry
+template<class Msgs>
+bool checkMsgBucketRange(const Msgs& msgs, uint64_t *e, const size_t *pos, size_t begin, size_t end)
+{
+	for (size_t b = begin; b < end; b++) {
+		if (!checkMsgEntry(msgs, e + pos[b], pos[b + 1] - pos[b])) return false;
+	}
+	return true;
+}
+
+/*
+	return buf[0, bufSize) aligned to 8 bytes if it has n entries else NULL
+*/
+inline uint64_t *getMsgEntryBuf(void *buf, size_t bufSize, size_t n)
+{
+	if (buf == 0 || n > (size_t(-1) - 8) / sizeof(uint64_t)) return 0;
+	const size_t pad = (sizeof(uint64_t) - size_t(buf) % sizeof(uint64_t)) % sizeof(uint64_t);
+	if (bufSize < pad + sizeof(uint64_t) * n) return 0;
+	return (uint64_t*)((char*)buf + pad);
+}
+
+/*
+	check the messages by the entries e[0, n)
+	the fingerprint of each message is computed once and the entries are sorted in O(n log n) time
+*/
+template<class Msgs>
+bool checkAllMsgDifferentEntry(const Msgs& msgs, uint64_t *e, size_t n)
+{
+	setMsgEntryVec(e, msgs, n, 0);
+	if (n < msgBucketN) return checkMsgEntry(msgs, e, n);
+	size_t pos[msgBucketN + 1];
+	distributeMsgEntry(e, n, pos);
+	return checkMsgBucketRange(msgs, e, pos, 0, msgBucketN);
+}
+
+/*
+	the messages are split into 2^bits parts by the top bits of their fingerprints
+	each part is checked by one pass over all the messages with a table on the stack
+*/
+inline bool isMsgPart(uint64_t fp, uint64_t part, int bits)
+{
+	return bits == 0 || (fp >> (64 - bits)) == part;
+}
+
+// the number of bits such that a part has BLS_MSG_CHECK_STACK_N / 2 messages on average
+inline int getMsgPartBits(size_t n)
+{
+	if (n <= BLS_MSG_CHECK_STACK_N) return 0;
+	int bits = 1;
+	while ((n >> bits) > BLS_MSG_CHECK_STACK_N / 2) bits++;
+	return bits;
+}
+
+/*
+	compare each pair of the messages of the part of 64 bits
+	only for more than BLS_MSG_CHECK_STACK_N different messages with the same fingerprint
+*/
+template<class Msgs>
+bool checkMsgPartByPair(const Msgs& msgs, size_t n, uint64_t part)
+{
+	for (size_t i = 0; i < n; i++) {
+		if (getMsgFingerprint(msgs.get(i), msgs.getSize(i)) != part) continue;
+		for (size_t j = i + 1; j < n; j++) {
+			if (isEqualMsg(msgs, i, j)) return false;
+		}
+	}
+	return true;
+}
+
+/*
+	return false if some of the messages in the part are the same
+	e[0, cap) is the table ; the part is split by one more bit if it does not fit in the table
+*/
+template<class Msgs>
+bool checkMsgPart(const Msgs& msgs, size_t n, uint64_t *e, size_t cap, uint64_t part, int bits)
+{
+	size_t m = 0;
+	for (size_t i = 0; i < n; i++) {
+		const uint64_t fp = getMsgFingerprint(msgs.get(i), msgs.getSize(i));
+		if (!isMsgPart(fp, part, bits)) continue;
+		if (m == cap) {
+			// the same messages fill the table
+			if (!checkMsgEntry(msgs, e, m)) return false;
+			if (bits == 64) return checkMsgPartByPair(msgs, n, part);
+			return checkMsgPart(msgs, n, e, cap, part * 2, bits + 1) && checkMsgPart(msgs, n, e, cap, part * 2 + 1, bits + 1);
+		}
+		e[m++] = (fp & 0xffffffff00000000ull) | uint64_t(i);
+	}
+	return checkMsgEntry(msgs, e, m);
+}
+
+// check the parts [begin, end) of 2^bits parts
+template<class Msgs>
+bool checkMsgPartRange(const Msgs& msgs, size_t n, int bits, uint64_t begin, uint64_t end)
+{
+	uint64_t e[BLS_MSG_CHECK_STACK_N];
+	for (uint64_t part = begin; part < end; part++) {
+		if (!checkMsgPart(msgs, n, e, BLS_MSG_CHECK_STACK_N, part, bits)) return false;
+	}
+	return true;
+}
+
+/*
+	return true if all messages are different from each other
+	buf[0, bufSize) is a scratch area of 8 bytes per message
+	if buf is NULL or too small, the check uses no heap but takes about 2n / BLS_MSG_CHECK_STACK_N passes
+	over the messages for n > BLS_MSG_CHECK_STACK_N
+	@note n must be less than 2^32
+*/
+template<class Msgs>
+bool checkAllMsgDifferent(const Msgs& msgs, size_t n, void *buf = 0, size_t bufSize = 0)
+{
+	if (uint64_t(n) >= 0xffffffffull) return false;
+	uint64_t *e = getMsgEntryBuf(buf, bufSize, n);
+	if (e) return checkAllMsgDifferentEntry(msgs, e, n);
+	const int bits = getMsgPartBits(n);
+	return checkMsgPartRange(msgs, n, bits, 0, uint64_t(1) << bits);
+}
+
+/*
+	return true if all bufSize / MSG_SIZE messages of MSG_SIZE bytes in buf are different
+*/
 inline bool areAllMsgDifferent(const void *buf, size_t bufSize)
 {
 	size_t n = bufSize / MSG_SIZE;
 	if (bufSize != n * MSG_SIZE) {
 		return false;
 	}
-	const Msg *msg = (const Msg*)buf;
-	typedef std::set<Msg> MsgSet;
-	MsgSet ms;
-	for (size_t i = 0; i < n; i++) {
-		std::pair<MsgSet::iterator, bool> ret = ms.insert(msg[i]);
-		if (!ret.second) return false;
-	}
-	return true;
+	return checkAllMsgDifferent(FixedSizeMsg(buf, MSG_SIZE), n);
 }
 
 } // bls_util
-
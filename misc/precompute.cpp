@@ -0,0 +1,100 @@
+/*
+	make src/precomputed-bls12_381.hpp for blsInit
+	precompute.exe [w] > src/precomputed-bls12_381.hpp
+	w ; the window of the tables of the generators (default BLS_FIXED_BASE_MAX_WINDOW)
+	the values are the internal (Montgomery) representation of 64-bit units
+*/
+#include <mcl/bls12_381.hpp>
+#include <stdio.h>
+#include <stdlib.h>
+#include "../src/fixed_base.hpp"
+
+using namespace mcl::bn;
+
+const size_t unitN = 6; // 384-bit Fp
+
+void putFp(const Fp& x)
+{
+	printf("{");
+	for (size_t i = 0; i < unitN; i++) {
+		printf("0x%016llxull,", (unsigned long long)x.getUnit()[i]);
+	}
+	printf("},");
+}
+
+template<class G>
+void putTbl(const char *name, const G& P, size_t w)
+{
+	static bls_fixed_base::TableT<G, Fr> tbl;
+	if (!tbl.init(P, w)) {
+		fprintf(stderr, "bad window %d\n", (int)w);
+		exit(1);
+	}
+	const mcl::Unit *p = tbl.getTable();
+	const size_t n = tbl.getTableUnitN();
+	printf("static const uint64_t %s[] = {\n", name);
+	for (size_t i = 0; i < n; i += unitN) {
+		printf("\t");
+		for (size_t j = 0; j < unitN; j++) {
+			printf("0x%016llxull,", (unsigned long long)p[i + j]);
+		}
+		printf("\n");
+	}
+	puts("};");
+}
+
+int main(int argc, char *argv[])
+{
+	const size_t w = argc > 1 ? (size_t)atoi(argv[1]) : bls_fixed_base::TableT<G1, Fr>::getMaxWindow();
+	bool b;
+	initPairing(&b, mcl::BLS12_381);
+	if (!b || Fp::getUnitSize() != unitN || sizeof(mcl::Unit) != 8) {
+		fprintf(stderr, "initPairing\n");
+		return 1;
+	}
+	// the generator of ETH mode (the same as blsInit)
+	G1 P;
+	P.setStr(&b, "1 3685416753713387016781088315183077757961620795782546409894578378688607592378376318836054947676345821548104185464507 1339506544944476473020471379941921221584933875938349620426543736416511423956333506472724655353366534992391756441569", 10);
+	if (!b) return 1;
+	// the generator of non-ETH mode (the same as blsInit)
+	G2 Q;
+	mapToG2(&b, Q, 1);
+	if (!b) return 1;
+	Q.normalize();
+	mcl::FixedArray<Fp6, 128> Qcoeff;
+	precomputeG2(&b, Qcoeff, Q);
+	if (!b) return 1;
+
+	puts("// generated by misc/precompute.cpp ; do not edit");
+	puts("#if MCL_SIZEOF_UNIT == 8");
+	puts("#ifdef BLS_ETH");
+	printf("static const uint64_t genBLS12_381[][%d] = {\n\t", (int)unitN);
+	putFp(P.x);
+	putFp(P.y);
+	puts("\n};");
+	printf("static const size_t genTblWindowBLS12_381 = %d;\n", (int)w);
+	putTbl("genTblBLS12_381", P, w);
+	puts("#else");
+	printf("static const uint64_t genBLS12_381[][%d] = {\n\t", (int)unitN);
+	putFp(Q.x.a);
+	putFp(Q.x.b);
+	putFp(Q.y.a);
+	putFp(Q.y.b);
+	puts("\n};");
+	printf("static const uint64_t QcoeffTblBLS12_381[][6][%d] = {\n", (int)unitN);
+	for (size_t i = 0; i < Qcoeff.size(); i++) {
+		const Fp6& x6 = Qcoeff[i];
+		puts("\t{");
+		for (size_t j = 0; j < 6; j++) {
+			printf("\t\t");
+			putFp(x6.getFp0()[j]);
+			puts("");
+		}
+		puts("\t},");
+	}
+	puts("};");
+	printf("static const size_t genTblWindowBLS12_381 = %d;\n", (int)w);
+	putTbl("genTblBLS12_381", Q, w);
+	puts("#endif");
+	puts("#endif");
+}
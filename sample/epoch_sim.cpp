@@ -0,0 +1,530 @@
+/*
+	epoch simulation of the Ethereum consensus layer (needs BLS_ETH=1)
+	epoch_sim.exe gen -v 16384 -o epoch.bin ; make a synthetic epoch
+	epoch_sim.exe run -i epoch.bin -t 4 ; verify it by the batch APIs with 4 threads
+
+	one epoch has 32 slots and every validator attests once in a committee of a slot
+	a slot has
+	- one block signature of the proposer ; blsVerify
+	- the signatures of the sync committee for the block root ; blsVerifySameMessageVec
+	- the attestations of the committees ; most members of a committee sign the same data
+	  and the others sign another head (-split) ; blsVerifySameMessageVec for each data
+	- the aggregates of the committees ; blsPublicKeyAdd and blsMultiVerify
+	  and blsVerify for each aggregate if it fails
+	  each aggregator aggregates a random subset (-cover) of the valid signatures of the majority
+	-bad is the fraction of invalid signatures
+	the keys are made by blsKeyGenVec from -seed
+*/
+#include <bls/bls384_256.h>
+#include <cybozu/option.hpp>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+
+#ifdef BLS_ETH
+
+const uint32_t slotN = 32;
+const uint32_t maxCommitteesPerSlot = 64;
+const uint32_t targetCommitteeSize = 128;
+const size_t msgSize = 32;
+const size_t pubSize = 48;
+const size_t sigSize = 96;
+const char magic[8] = { 'B', 'L', 'S', 'E', 'P', 'O', 'C', 'H' };
+const uint32_t version = 1;
+
+struct Msg {
+	uint8_t v[msgSize];
+};
+
+struct Sig {
+	uint8_t v[sigSize];
+};
+
+struct Attestation {
+	uint32_t validator;
+	uint8_t valid;
+	Msg msg;
+	Sig sig;
+};
+
+struct Aggregate {
+	uint8_t valid;
+	Msg msg;
+	std::vector<uint32_t> members;
+	Sig sig;
+};
+
+struct Slot {
+	uint32_t proposer;
+	uint8_t blockValid;
+	Msg blockRoot;
+	Sig blockSig;
+	std::vector<Attestation> syncVec; // sign blockRoot
+	std::vector<Attestation> attVec;
+	std::vector<Aggregate> aggVec;
+};
+
+struct Epoch {
+	uint32_t validatorN;
+	uint32_t committeesPerSlot;
+	std::vector<uint8_t> pubVec; // serialized public keys
+	std::vector<Slot> slotVec;
+};
+
+// xorshift64 for the synthetic data (not for keys)
+struct Rand {
+	uint64_t x;
+	explicit Rand(uint64_t seed) : x(seed ? seed : 1) {}
+	uint64_t get()
+	{
+		x ^= x << 13;
+		x ^= x >> 7;
+		x ^= x << 17;
+		return x;
+	}
+	double getDouble() { return (get() >> 11) * (1.0 / 9007199254740992.0); }
+	uint32_t get(uint32_t n) { return uint32_t(get() % n); }
+};
+
+void setMsg(Msg& m, uint32_t kind, uint32_t slot, uint32_t idx, uint32_t variant)
+{
+	memset(m.v, 0, msgSize);
+	const uint32_t v[] = { kind, slot, idx, variant };
+	memcpy(m.v, v, sizeof(v));
+}
+
+void serialize(Sig& s, const blsSignature& sig)
+{
+	blsSignatureSerialize(s.v, sigSize, &sig);
+}
+
+// out[i] = signature of msg by secVec[idx[i]]
+void signVec(std::vector<Sig>& out, const std::vector<blsSecretKey>& secVec, const std::vector<uint32_t>& idx, const Msg& msg, int threadN)
+{
+	const size_t n = idx.size();
+	out.resize(n);
+	if (n == 0) return;
+	std::vector<blsSecretKey> sv(n);
+	std::vector<blsSignature> sigVec(n);
+	for (size_t i = 0; i < n; i++) sv[i] = secVec[idx[i]];
+	blsSignManyKeys(&sigVec[0], &sv[0], n, msg.v, msgSize, threadN);
+	for (size_t i = 0; i < n; i++) serialize(out[i], sigVec[i]);
+}
+
+// an invalid signature signs msg with the last byte changed
+void corrupt(Sig& s, const blsSecretKey& sec, const Msg& msg)
+{
+	Msg m = msg;
+	m.v[msgSize - 1] ^= 1;
+	blsSignature sig;
+	blsSign(&sig, &sec, m.v, msgSize);
+	serialize(s, sig);
+}
+
+void generate(Epoch& e, uint32_t validatorN, uint32_t syncN, uint32_t aggregatorN, double cover, double split, double bad, uint64_t seed, int threadN)
+{
+	Rand rg(seed);
+	e.validatorN = validatorN;
+	e.committeesPerSlot = std::max<uint32_t>(1, std::min(maxCommitteesPerSlot, validatorN / slotN / targetCommitteeSize));
+	std::vector<blsSecretKey> secVec(validatorN);
+	std::vector<blsPublicKey> pubVec(validatorN);
+	const int w = blsGetGeneratorTableWindow();
+	blsSetGeneratorTableWindow(blsGetMaxGeneratorTableWindow());
+	blsKeyGenVec(&secVec[0], &pubVec[0], validatorN, &seed, sizeof(seed), 0, threadN);
+	blsSetGeneratorTableWindow(w);
+	e.pubVec.resize(size_t(validatorN) * pubSize);
+	for (uint32_t i = 0; i < validatorN; i++) {
+		blsPublicKeySerialize(&e.pubVec[size_t(i) * pubSize], pubSize, &pubVec[i]);
+	}
+	// shuffle the validators into the committees
+	std::vector<uint32_t> perm(validatorN);
+	for (uint32_t i = 0; i < validatorN; i++) perm[i] = i;
+	for (uint32_t i = validatorN; i > 1; i--) std::swap(perm[i - 1], perm[rg.get(i)]);
+	const uint32_t committeeN = slotN * e.committeesPerSlot;
+	e.slotVec.resize(slotN);
+	std::vector<Sig> sigs;
+	for (uint32_t s = 0; s < slotN; s++) {
+		Slot& slot = e.slotVec[s];
+		slot.proposer = rg.get(validatorN);
+		setMsg(slot.blockRoot, 0, s, 0, 0);
+		blsSignature sig;
+		blsSign(&sig, &secVec[slot.proposer], slot.blockRoot.v, msgSize);
+		serialize(slot.blockSig, sig);
+		slot.blockValid = rg.getDouble() >= bad;
+		if (!slot.blockValid) corrupt(slot.blockSig, secVec[slot.proposer], slot.blockRoot);
+		// sync committee
+		std::vector<uint32_t> idx(std::min(syncN, validatorN));
+		for (size_t i = 0; i < idx.size(); i++) idx[i] = perm[(size_t(s) * 7919 + i) % validatorN];
+		signVec(sigs, secVec, idx, slot.blockRoot, threadN);
+		slot.syncVec.resize(idx.size());
+		for (size_t i = 0; i < idx.size(); i++) {
+			Attestation& a = slot.syncVec[i];
+			a.validator = idx[i];
+			a.msg = slot.blockRoot;
+			a.sig = sigs[i];
+			a.valid = rg.getDouble() >= bad;
+			if (!a.valid) corrupt(a.sig, secVec[a.validator], a.msg);
+		}
+		// attestations of the committees
+		for (uint32_t c = 0; c < e.committeesPerSlot; c++) {
+			const uint32_t committee = s * e.committeesPerSlot + c;
+			const size_t begin = size_t(validatorN) * committee / committeeN;
+			const size_t end = size_t(validatorN) * (committee + 1) / committeeN;
+			Msg msg[2];
+			setMsg(msg[0], 1, s, c, 0);
+			setMsg(msg[1], 1, s, c, 1);
+			std::vector<uint32_t> idxVec[2];
+			for (size_t i = begin; i < end; i++) {
+				idxVec[rg.getDouble() < split ? 1 : 0].push_back(perm[i]);
+			}
+			for (int k = 0; k < 2; k++) {
+				signVec(sigs, secVec, idxVec[k], msg[k], threadN);
+				std::vector<blsSignature> validSigVec;
+				std::vector<uint32_t> validIdx;
+				for (size_t i = 0; i < idxVec[k].size(); i++) {
+					Attestation a;
+					a.validator = idxVec[k][i];
+					a.msg = msg[k];
+					a.sig = sigs[i];
+					a.valid = rg.getDouble() >= bad;
+					if (a.valid) {
+						blsSignature sig;
+						blsSignatureDeserialize(&sig, a.sig.v, sigSize);
+						validSigVec.push_back(sig);
+						validIdx.push_back(a.validator);
+					} else {
+						corrupt(a.sig, secVec[a.validator], a.msg);
+					}
+					slot.attVec.push_back(a);
+				}
+				// the aggregators aggregate the valid signatures of the majority which they have received
+				if (k == 1 || validSigVec.empty()) continue;
+				for (uint32_t j = 0; j < aggregatorN; j++) {
+					Aggregate agg;
+					agg.msg = msg[k];
+					std::vector<blsSignature> aggSigVec;
+					for (size_t i = 0; i < validIdx.size(); i++) {
+						if (rg.getDouble() >= cover) continue;
+						agg.members.push_back(validIdx[i]);
+						aggSigVec.push_back(validSigVec[i]);
+					}
+					if (agg.members.empty()) {
+						const size_t i = rg.get(uint32_t(validIdx.size()));
+						agg.members.push_back(validIdx[i]);
+						aggSigVec.push_back(validSigVec[i]);
+					}
+					blsSignature sig;
+					blsAggregateSignature(&sig, &aggSigVec[0], aggSigVec.size());
+					serialize(agg.sig, sig);
+					agg.valid = rg.getDouble() >= bad;
+					if (!agg.valid) corrupt(agg.sig, secVec[agg.members[0]], agg.msg);
+					slot.aggVec.push_back(agg);
+				}
+			}
+		}
+		fprintf(stderr, "slot %u: %d attestations, %d aggregates\n", s, (int)slot.attVec.size(), (int)slot.aggVec.size());
+	}
+}
+
+template<class T>
+void write(FILE *fp, const T& x) { fwrite(&x, sizeof(x), 1, fp); }
+template<class T>
+bool read(FILE *fp, T& x) { return fread(&x, sizeof(x), 1, fp) == 1; }
+
+void writeAtt(FILE *fp, const Attestation& a)
+{
+	write(fp, a.validator);
+	write(fp, a.valid);
+	write(fp, a.msg);
+	write(fp, a.sig);
+}
+
+bool readAtt(FILE *fp, Attestation& a)
+{
+	return read(fp, a.validator) && read(fp, a.valid) && read(fp, a.msg) && read(fp, a.sig);
+}
+
+/*
+	file format (little endian)
+	magic, version, validatorN, committeesPerSlot, public keys
+	for each slot ; proposer, blockValid, blockRoot, blockSig,
+	syncN, sync attestations, attN, attestations,
+	aggN, (valid, msg, memberN, members, sig) of aggregates
+*/
+bool save(const Epoch& e, const std::string& file)
+{
+	FILE *fp = fopen(file.c_str(), "wb");
+	if (fp == 0) return false;
+	fwrite(magic, sizeof(magic), 1, fp);
+	write(fp, version);
+	write(fp, e.validatorN);
+	write(fp, e.committeesPerSlot);
+	fwrite(&e.pubVec[0], 1, e.pubVec.size(), fp);
+	for (size_t s = 0; s < e.slotVec.size(); s++) {
+		const Slot& slot = e.slotVec[s];
+		write(fp, slot.proposer);
+		write(fp, slot.blockValid);
+		write(fp, slot.blockRoot);
+		write(fp, slot.blockSig);
+		write(fp, uint32_t(slot.syncVec.size()));
+		for (size_t i = 0; i < slot.syncVec.size(); i++) writeAtt(fp, slot.syncVec[i]);
+		write(fp, uint32_t(slot.attVec.size()));
+		for (size_t i = 0; i < slot.attVec.size(); i++) writeAtt(fp, slot.attVec[i]);
+		write(fp, uint32_t(slot.aggVec.size()));
+		for (size_t i = 0; i < slot.aggVec.size(); i++) {
+			const Aggregate& agg = slot.aggVec[i];
+			write(fp, agg.valid);
+			write(fp, agg.msg);
+			write(fp, uint32_t(agg.members.size()));
+			fwrite(&agg.members[0], sizeof(uint32_t), agg.members.size(), fp);
+			write(fp, agg.sig);
+		}
+	}
+	return fclose(fp) == 0;
+}
+
+// read an attestation whose validator is less than validatorN
+bool readAtt(FILE *fp, Attestation& a, uint32_t validatorN)
+{
+	return readAtt(fp, a) && a.validator < validatorN;
+}
+
+// read the number of the entries, which is at most maxN, and resize v
+template<class T>
+bool readSize(FILE *fp, std::vector<T>& v, uint32_t maxN)
+{
+	uint32_t n;
+	if (!read(fp, n) || n > maxN) return false;
+	v.resize(n);
+	return true;
+}
+
+/*
+	return false if the file is broken
+	the indices of the validators are less than validatorN
+	a slot has at most validatorN attestations, aggregates of at most validatorN members
+	and an aggregate has at least one member
+*/
+bool load(Epoch& e, const std::string& file)
+{
+	FILE *fp = fopen(file.c_str(), "rb");
+	if (fp == 0) return false;
+	char m[sizeof(magic)];
+	uint32_t ver;
+	bool ok = fread(m, sizeof(m), 1, fp) == 1 && memcmp(m, magic, sizeof(m)) == 0
+		&& read(fp, ver) && ver == version
+		&& read(fp, e.validatorN) && e.validatorN > 0
+		&& read(fp, e.committeesPerSlot) && e.committeesPerSlot > 0 && e.committeesPerSlot <= maxCommitteesPerSlot;
+	if (ok) {
+		e.pubVec.resize(size_t(e.validatorN) * pubSize);
+		ok = fread(&e.pubVec[0], 1, e.pubVec.size(), fp) == e.pubVec.size();
+	}
+	e.slotVec.resize(slotN);
+	const uint32_t maxN = e.validatorN;
+	for (size_t s = 0; ok && s < slotN; s++) {
+		Slot& slot = e.slotVec[s];
+		ok = read(fp, slot.proposer) && slot.proposer < maxN && read(fp, slot.blockValid) && read(fp, slot.blockRoot) && read(fp, slot.blockSig)
+			&& readSize(fp, slot.syncVec, maxN);
+		for (size_t i = 0; ok && i < slot.syncVec.size(); i++) ok = readAtt(fp, slot.syncVec[i], maxN);
+		ok = ok && readSize(fp, slot.attVec, maxN);
+		for (size_t i = 0; ok && i < slot.attVec.size(); i++) ok = readAtt(fp, slot.attVec[i], maxN);
+		ok = ok && readSize(fp, slot.aggVec, maxN);
+		for (size_t i = 0; ok && i < slot.aggVec.size(); i++) {
+			Aggregate& agg = slot.aggVec[i];
+			ok = read(fp, agg.valid) && read(fp, agg.msg) && readSize(fp, agg.members, maxN) && !agg.members.empty();
+			if (!ok) break;
+			const size_t n = agg.members.size();
+			ok = fread(&agg.members[0], sizeof(uint32_t), n, fp) == n && read(fp, agg.sig);
+			for (size_t j = 0; ok && j < n; j++) ok = agg.members[j] < maxN;
+		}
+	}
+	fclose(fp);
+	return ok;
+}
+
+struct Stat {
+	size_t sigN; // the number of verified signatures
+	size_t invalidN; // the number of signatures found invalid
+	size_t errN; // the number of wrong results
+	Stat() : sigN(0), invalidN(0), errN(0) {}
+};
+
+// randVec[i] by CSPRNG
+void setRand(std::vector<uint64_t>& randVec)
+{
+	for (size_t i = 0; i < randVec.size(); i += 4) {
+		blsSecretKey r;
+		blsSecretKeySetByCSPRNG(&r);
+		uint64_t buf[4];
+		blsSecretKeySerialize(buf, sizeof(buf), &r);
+		for (size_t j = 0; j < 4 && i + j < randVec.size(); j++) randVec[i + j] = buf[j];
+	}
+}
+
+/*
+	verify the attestations sorted by msg
+	by blsVerifySameMessageVec for each msg
+*/
+void verifyAttestations(Stat& st, const std::vector<Attestation>& attVec, const std::vector<blsPublicKey>& pubVec, int threadN)
+{
+	const size_t n = attVec.size();
+	std::vector<blsSignature> sigVec(n);
+	std::vector<blsPublicKey> pv(n);
+	std::vector<uint64_t> randVec(n);
+	std::vector<uint8_t> okVec(n);
+	for (size_t i = 0; i < n; i++) {
+		blsSignatureDeserialize(&sigVec[i], attVec[i].sig.v, sigSize);
+		pv[i] = pubVec[attVec[i].validator];
+	}
+	setRand(randVec);
+	size_t begin = 0;
+	while (begin < n) {
+		size_t end = begin + 1;
+		while (end < n && memcmp(attVec[end].msg.v, attVec[begin].msg.v, msgSize) == 0) end++;
+		const size_t m = end - begin;
+		const size_t okN = blsVerifySameMessageVec(&okVec[begin], &sigVec[begin], &pv[begin], m, attVec[begin].msg.v, msgSize, &randVec[begin], 8, threadN);
+		st.sigN += m;
+		st.invalidN += m - okN;
+		for (size_t i = begin; i < end; i++) {
+			if (okVec[i] != attVec[i].valid) st.errN++;
+		}
+		begin = end;
+	}
+}
+
+void verifyAggregates(Stat& st, const std::vector<Aggregate>& aggVec, const std::vector<blsPublicKey>& pubVec, int threadN)
+{
+	const size_t n = aggVec.size();
+	if (n == 0) return;
+	std::vector<blsSignature> sigVec(n);
+	std::vector<blsPublicKey> aggPubVec(n);
+	std::vector<uint8_t> msgVec(n * msgSize);
+	std::vector<uint64_t> randVec(n);
+	for (size_t i = 0; i < n; i++) {
+		const Aggregate& agg = aggVec[i];
+		blsSignatureDeserialize(&sigVec[i], agg.sig.v, sigSize);
+		aggPubVec[i] = pubVec[agg.members[0]];
+		for (size_t j = 1; j < agg.members.size(); j++) {
+			blsPublicKeyAdd(&aggPubVec[i], &pubVec[agg.members[j]]);
+		}
+		memcpy(&msgVec[i * msgSize], agg.msg.v, msgSize);
+	}
+	setRand(randVec);
+	st.sigN += n;
+	std::vector<blsSignature> sv = sigVec; // blsMultiVerify may normalize sigVec
+	if (blsMultiVerify(&sv[0], &aggPubVec[0], &msgVec[0], msgSize, &randVec[0], 8, n, threadN)) {
+		for (size_t i = 0; i < n; i++) {
+			if (!aggVec[i].valid) st.errN++;
+		}
+		return;
+	}
+	// find the invalid ones
+	for (size_t i = 0; i < n; i++) {
+		const int ok = blsVerify(&sigVec[i], &aggPubVec[i], &msgVec[i * msgSize], msgSize);
+		if (!ok) st.invalidN++;
+		if (ok != aggVec[i].valid) st.errN++;
+	}
+}
+
+bool cmpMsg(const Attestation& a, const Attestation& b)
+{
+	return memcmp(a.msg.v, b.msg.v, msgSize) < 0;
+}
+
+int run(const std::string& file, int threadN)
+{
+	Epoch e;
+	if (!load(e, file)) {
+		fprintf(stderr, "can't load %s\n", file.c_str());
+		return 1;
+	}
+	std::vector<blsPublicKey> pubVec(e.validatorN);
+	for (uint32_t i = 0; i < e.validatorN; i++) {
+		if (blsPublicKeyDeserialize(&pubVec[i], &e.pubVec[size_t(i) * pubSize], pubSize) == 0) {
+			fprintf(stderr, "bad public key %u\n", i);
+			return 1;
+		}
+	}
+	printf("validators=%u committeesPerSlot=%u threadN=%d\n", e.validatorN, e.committeesPerSlot, threadN);
+	Stat st;
+	std::vector<double> latency(slotN);
+	const std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+	for (size_t s = 0; s < slotN; s++) {
+		Slot& slot = e.slotVec[s];
+		// group the attestations of the same data
+		std::stable_sort(slot.attVec.begin(), slot.attVec.end(), cmpMsg);
+		const std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+		blsSignature sig;
+		blsSignatureDeserialize(&sig, slot.blockSig.v, sigSize);
+		const int ok = blsVerify(&sig, &pubVec[slot.proposer], slot.blockRoot.v, msgSize);
+		st.sigN++;
+		if (!ok) st.invalidN++;
+		if (ok != slot.blockValid) st.errN++;
+		verifyAttestations(st, slot.syncVec, pubVec, threadN);
+		verifyAttestations(st, slot.attVec, pubVec, threadN);
+		verifyAggregates(st, slot.aggVec, pubVec, threadN);
+		latency[s] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t1).count();
+	}
+	const double total = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+	std::vector<double> sorted = latency;
+	std::sort(sorted.begin(), sorted.end());
+	printf("signatures=%d invalid=%d wrong=%d\n", (int)st.sigN, (int)st.invalidN, (int)st.errN);
+	printf("total %.3f sec, %.0f signatures/sec\n", total, st.sigN / total);
+	printf("slot latency msec min=%.2f p50=%.2f p90=%.2f max=%.2f\n", sorted[0], sorted[slotN / 2], sorted[slotN * 9 / 10], sorted[slotN - 1]);
+	return st.errN == 0 ? 0 : 1;
+}
+
+int main(int argc, char *argv[])
+{
+	std::string mode, inFile, outFile;
+	uint32_t validatorN, syncN, aggregatorN;
+	double cover, split, bad;
+	int threadN;
+	uint64_t seed;
+	cybozu::Option opt;
+	opt.appendParam(&mode, "gen|run");
+	opt.appendOpt(&validatorN, 16384, "v", ": the number of validators (about 1000000 for mainnet)");
+	opt.appendOpt(&syncN, 512, "sync", ": the size of the sync committee");
+	opt.appendOpt(&aggregatorN, 16, "agg", ": the number of aggregators of a committee");
+	opt.appendOpt(&cover, 0.8, "cover", ": the fraction of the valid signatures which an aggregator aggregates");
+	opt.appendOpt(&split, 0.05, "split", ": the fraction of a committee which signs another head");
+	opt.appendOpt(&bad, 0.001, "bad", ": the fraction of invalid signatures");
+	opt.appendOpt(&seed, 1, "seed", ": seed of the synthetic data");
+	opt.appendOpt(&threadN, 1, "t", ": the number of threads");
+	opt.appendOpt(&inFile, "epoch.bin", "i", ": input file of run");
+	opt.appendOpt(&outFile, "epoch.bin", "o", ": output file of gen");
+	opt.appendHelp("h");
+	if (!opt.parse(argc, argv) || validatorN == 0) {
+		opt.usage();
+		return 1;
+	}
+	if (blsInit(MCL_BLS12_381, MCLBN_COMPILED_TIME_VAR) != 0) {
+		fprintf(stderr, "blsInit\n");
+		return 1;
+	}
+	if (mode == "gen") {
+		Epoch e;
+		generate(e, validatorN, syncN, aggregatorN, cover, split, bad, seed, threadN);
+		if (!save(e, outFile)) {
+			fprintf(stderr, "can't save %s\n", outFile.c_str());
+			return 1;
+		}
+		return 0;
+	}
+	if (mode == "run") return run(inFile, threadN);
+	opt.usage();
+	return 1;
+}
+
+#else
+
+int main()
+{
+	fprintf(stderr, "epoch_sim needs BLS_ETH=1\n");
+	return 1;
+}
+
+#endif
@@ -1,23 +1,77 @@
 #include "../src/cast.hpp"
 #include <mcl/lagrange.hpp>
+#include <bls/msg.hpp>
+#include "../src/sha256.hpp"
+#include "../src/fixed_base.hpp"
 
 #if (CYBOZU_CPP_VERSION >= CYBOZU_CPP_VERSION_CPP11) && !defined(__EMSCRIPTEN__) && !defined(__wasm__)
 #include <thread>
 #define BLS_MULTI_VERIFY_THREAD
 #endif
 
+#ifndef BLS_MINIMUM_API
+#include "../src/stats.hpp"
+#include "../src/trace.hpp"
+#else
+#define BLS_STAT_SCOPE(kind, n)
+#define BLS_TRACE_SCOPE(phase, n)
+#endif
+
 using namespace mcl;
 
-inline void Gmul(G1& z, const G1& x, const Fr& y) { G1::mul(z, x, y); }
-inline void Gmul(G2& z, const G2& x, const Fr& y) { G2::mul(z, x, y); }
-inline void GmulCT(G1& z, const G1& x, const Fr& y) { G1::mulCT(z, x, y); }
-inline void GmulCT(G2& z, const G2& x, const Fr& y) { G2::mulCT(z, x, y); }
+inline void Gmul(G1& z, const G1& x, const Fr& y) { BLS_STAT_SCOPE(BLS_STAT_MUL, 1); G1::mul(z, x, y); }
+inline void Gmul(G2& z, const G2& x, const Fr& y) { BLS_STAT_SCOPE(BLS_STAT_MUL, 1); G2::mul(z, x, y); }
+inline void GmulCT(G1& z, const G1& x, const Fr& y) { BLS_STAT_SCOPE(BLS_STAT_MUL, 1); G1::mulCT(z, x, y); }
+inline void GmulCT(G2& z, const G2& x, const Fr& y) { BLS_STAT_SCOPE(BLS_STAT_MUL, 1); G2::mulCT(z, x, y); }
 inline void Gneg(G1& y, const G1& x) { G1::neg(y, x); }
 inline void Gneg(G2& y, const G2& x) { G2::neg(y, x); }
-inline void GmulVec(G1& z, G1* x, const Fr *y, mclSize n) { G1::mulVec(z, x, y, n); }
-inline void GmulVec(G2& z, G2* x, const Fr *y, mclSize n) { G2::mulVec(z, x, y, n); }
-inline void hashAndMapToG(G1& z, const void *m, mclSize size) { hashAndMapToG1(z, m, size); }
-inline void hashAndMapToG(G2& z, const void *m, mclSize size) { hashAndMapToG2(z, m, size); }
+inline void GmulVec(G1& z, G1* x, const Fr *y, mclSize n)
+{
+	BLS_STAT_SCOPE(BLS_STAT_MUL_VEC, n);
+	BLS_TRACE_SCOPE(BLS_PHASE_MUL, n);
+	G1::mulVec(z, x, y, n);
+}
+inline void GmulVec(G2& z, G2* x, const Fr *y, mclSize n)
+{
+	BLS_STAT_SCOPE(BLS_STAT_MUL_VEC, n);
+	BLS_TRACE_SCOPE(BLS_PHASE_MUL, n);
+	G2::mulVec(z, x, y, n);
+}
+
+/*
+	the pairing primitives counted by blsGetStats and reported to blsTraceCallback
+	the count of a Miller loop is the number of the pairs
+*/
+inline void statMillerLoop(GT& e, const G1& P, const G2& Q)
+{
+	BLS_STAT_SCOPE(BLS_STAT_MILLER_LOOP, 1);
+	BLS_TRACE_SCOPE(BLS_PHASE_MILLER_LOOP, 1);
+	millerLoop(e, P, Q);
+}
+inline void statMillerLoopVec(GT& e, const G1 *Pvec, const G2 *Qvec, size_t n, bool initE = true)
+{
+	BLS_STAT_SCOPE(BLS_STAT_MILLER_LOOP, n);
+	BLS_TRACE_SCOPE(BLS_PHASE_MILLER_LOOP, n);
+	millerLoopVec(e, Pvec, Qvec, n, initE);
+}
+inline void statPrecomputedMillerLoop(GT& e, const G1& P, const Fp6 *Qcoeff)
+{
+	BLS_STAT_SCOPE(BLS_STAT_MILLER_LOOP, 1);
+	BLS_TRACE_SCOPE(BLS_PHASE_MILLER_LOOP, 1);
+	precomputedMillerLoop(e, P, Qcoeff);
+}
+inline void statPrecomputedMillerLoop2mixed(GT& e, const G1& P1, const G2& Q1, const G1& P2, const Fp6 *Q2coeff)
+{
+	BLS_STAT_SCOPE(BLS_STAT_MILLER_LOOP, 2);
+	BLS_TRACE_SCOPE(BLS_PHASE_MILLER_LOOP, 2);
+	precomputedMillerLoop2mixed(e, P1, Q1, P2, Q2coeff);
+}
+inline void statFinalExp(GT& y, const GT& x)
+{
+	BLS_STAT_SCOPE(BLS_STAT_FINAL_EXP, 1);
+	BLS_TRACE_SCOPE(BLS_PHASE_FINAL_EXP, 1);
+	finalExp(y, x);
+}
 
 /*
 	BLS signature
@@ -49,18 +103,253 @@ static bool g_irtfHashAndMap;
 #ifdef BLS_ETH
 typedef G2 G;
 typedef G1 Gother;
-static G1 g_P;
-inline const G1& getBasePoint() { return g_P; }
 #else
 typedef G1 G;
 typedef G2 Gother;
-static G2 g_Q;
 const size_t maxQcoeffN = 128;
-static FixedArray<Fp6, maxQcoeffN> g_Qcoeff; // precomputed Q
-inline const G2& getBasePoint() { return g_Q; }
-inline const FixedArray<Fp6, maxQcoeffN>& getQcoeff() { return g_Qcoeff; }
 #endif
 
+/*
+	the settings of blsContext
+	gen ; the generator of PublicKey
+	Qcoeff ; precomputed gen
+	expandMsg ; expand_message_xmd with the cached midstate of DST used if hasDst
+	followMcl ; expandMsg has the DST of mcl (set by blsSetDst) and is used only while mcl keeps it
+	probe ; the hash of g_probeMsg by mcl when expandMsg is set if followMcl
+*/
+struct Context {
+	Gother gen;
+#ifdef BLS_ETH
+	bls_sha256::ExpandMsgXmd expandMsg;
+	bool hasDst;
+	bool followMcl;
+	G2 probe;
+#else
+	FixedArray<Fp6, maxQcoeffN> Qcoeff;
+#endif
+	// placement new for blsContextInit without <new> (not available in the minimized build)
+	static void *operator new(size_t, void *p) { return p; }
+	static void operator delete(void *, void *) {}
+};
+
+// the context of the functions without blsContext
+static Context g_ctx;
+
+inline const Gother& getBasePoint() { return g_ctx.gen; }
+#ifndef BLS_ETH
+inline const FixedArray<Fp6, maxQcoeffN>& getQcoeff() { return g_ctx.Qcoeff; }
+#endif
+
+/*
+	the window table of the generator for blsGetPublicKey and blsKeyGenVec
+	disabled if not initialized ; remade with the same window when the generator changes
+*/
+static bls_fixed_base::TableT<Gother, Fr> g_genTbl;
+
+#if defined(BLS_PRECOMPUTED_TBL) && MCL_SIZEOF_UNIT == 8
+/*
+	the generator, Qcoeff and the table of the generator for BLS12-381 made by misc/precompute.cpp
+	make src/precomputed-bls12_381.hpp and define BLS_PRECOMPUTED_TBL to use them
+	the header does not depend on the target, so make it on a native 64-bit host for cross builds
+*/
+#if defined(__has_include)
+	#if !__has_include("./precomputed-bls12_381.hpp")
+		#error "BLS_PRECOMPUTED_TBL needs src/precomputed-bls12_381.hpp made by make precomputed (see readme.md)"
+	#endif
+#endif
+#include "./precomputed-bls12_381.hpp"
+#define BLS_USE_PRECOMPUTED_TBL
+
+inline bool hasPrecomputedTbl()
+{
+	return g_curveType == MCL_BLS12_381 && sizeof(Fp) == sizeof(genBLS12_381[0]);
+}
+
+inline void setPrecomputedFp(Fp& x, const uint64_t *p)
+{
+	Unit *q = const_cast<Unit*>(x.getUnit());
+	for (size_t i = 0; i < sizeof(genBLS12_381[0]) / sizeof(Unit); i++) {
+		q[i] = p[i];
+	}
+}
+
+inline void getPrecomputedGen(G1& P)
+{
+	setPrecomputedFp(P.x, genBLS12_381[0]);
+	setPrecomputedFp(P.y, genBLS12_381[1]);
+	P.z = 1;
+}
+
+inline void getPrecomputedGen(G2& Q)
+{
+	setPrecomputedFp(Q.x.a, genBLS12_381[0]);
+	setPrecomputedFp(Q.x.b, genBLS12_381[1]);
+	setPrecomputedFp(Q.y.a, genBLS12_381[2]);
+	setPrecomputedFp(Q.y.b, genBLS12_381[3]);
+	Q.z = 1;
+}
+#endif
+
+// make g_genTbl of w for the current generator (copy the precomputed one if possible)
+inline bool initGenTbl(size_t w)
+{
+#ifdef BLS_USE_PRECOMPUTED_TBL
+	if (w == genTblWindowBLS12_381 && hasPrecomputedTbl()) {
+		Gother P;
+		getPrecomputedGen(P);
+		if (P == getBasePoint() && g_genTbl.setTable(P, w, (const Unit*)genTblBLS12_381, CYBOZU_NUM_OF_ARRAY(genTblBLS12_381))) {
+			return true;
+		}
+	}
+#endif
+	return g_genTbl.init(getBasePoint(), w);
+}
+
+inline bool updateGenTbl()
+{
+	if (!g_genTbl.isInitialized()) return true;
+	return initGenTbl(g_genTbl.getWindow());
+}
+
+#ifdef BLS_ETH
+/*
+	map u = hash_to_field(msg, 2) in md[0, 256) to G2
+	clear_cofactor(Q0 + Q1) = clear_cofactor(Q0) + clear_cofactor(Q1)
+	so the sum of mapToG2 of u[0] and u[1] in hash-to-curve mode is the hash-to-curve of msg
+*/
+inline void mapToGfromExpandedMsg(G2& z, const uint8_t *md)
+{
+	Fp2 u[2];
+	for (size_t i = 0; i < 4; i++) {
+		bool b;
+		u[i / 2].getFp0()[i % 2].setBigEndianMod(&b, md + 64 * i, 64);
+		assert(b);
+		(void)b;
+	}
+	G2 t;
+	bool b;
+	mapToG2(&b, z, u[0]);
+	assert(b);
+	mapToG2(&b, t, u[1]);
+	assert(b);
+	(void)b;
+	z += t;
+}
+
+static const char g_probeMsg[] = "probe of the DST of mcl";
+static const char *g_defaultDst = "BLS_SIG_BLS12381G2_XMD:SHA-256_SSWU_RO_POP_";
+// the DST given to mcl by blsSetDst
+static char g_mclDst[bls_sha256::ExpandMsgXmd::maxDstSize];
+static size_t g_mclDstSize;
+
+inline void expandAndMapToG(const Context& ctx, G2& z, const void *m, mclSize size)
+{
+	uint8_t md[256];
+	ctx.expandMsg.expand(md, sizeof(md), m, size);
+	mapToGfromExpandedMsg(z, md);
+}
+
+/*
+	set the midstate of g_ctx by dst which is assumed to be the DST of mcl
+	it is enabled only if it gives the same hash as mcl, so a wrong DST only makes the hash slower
+*/
+inline bool updateGlobalDst(const char *dst, size_t dstSize)
+{
+	g_ctx.hasDst = false;
+	g_ctx.followMcl = true;
+	if (g_curveType != MCL_BLS12_381 || getMapToMode() != MCL_MAP_TO_MODE_HASH_TO_CURVE_07) return false;
+	if (dstSize > bls_sha256::ExpandMsgXmd::maxDstSize) return false;
+	g_ctx.expandMsg.setDst(dst, dstSize);
+	hashAndMapToG2(g_ctx.probe, g_probeMsg, sizeof(g_probeMsg) - 1);
+	G2 Q;
+	expandAndMapToG(g_ctx, Q, g_probeMsg, sizeof(g_probeMsg) - 1);
+	g_ctx.hasDst = Q == g_ctx.probe;
+	return g_ctx.hasDst;
+}
+
+inline void setGlobalDst(const char *dst, size_t dstSize)
+{
+	if (dstSize <= bls_sha256::ExpandMsgXmd::maxDstSize) {
+		memcpy(g_mclDst, dst, dstSize);
+		g_mclDstSize = dstSize;
+	}
+	updateGlobalDst(dst, dstSize);
+}
+
+/*
+	return true if hashAndMapToGVec of ctx uses the midstate for n messages
+	the midstate of the DST of mcl is used while mcl keeps the DST and the map-to mode of hash-to-curve
+	mcl has no getter of DST, so the hash of g_probeMsg by mcl is compared, which costs one message
+*/
+inline bool useExpandMsg(const Context& ctx, size_t n)
+{
+	if (!ctx.hasDst) return false;
+	if (!ctx.followMcl) return true;
+	const size_t minN = 32;
+	if (n < minN || getMapToMode() != MCL_MAP_TO_MODE_HASH_TO_CURVE_07) return false;
+	G2 P;
+	hashAndMapToG2(P, g_probeMsg, sizeof(g_probeMsg) - 1);
+	return P == ctx.probe;
+}
+#else
+inline bool useExpandMsg(const Context&, size_t) { return false; }
+#endif
+
+inline void hashAndMapToG(const Context&, G1& z, const void *m, mclSize size)
+{
+	BLS_STAT_SCOPE(BLS_STAT_HASH_TO_CURVE, 1);
+	BLS_TRACE_SCOPE(BLS_PHASE_HASH, 1);
+	hashAndMapToG1(z, m, size);
+}
+inline void hashAndMapToG(const Context& ctx, G2& z, const void *m, mclSize size)
+{
+	BLS_STAT_SCOPE(BLS_STAT_HASH_TO_CURVE, 1);
+	BLS_TRACE_SCOPE(BLS_PHASE_HASH, 1);
+#ifdef BLS_ETH
+	if (ctx.hasDst && !ctx.followMcl) {
+		expandAndMapToG(ctx, z, m, size);
+		return;
+	}
+#else
+	(void)ctx;
+#endif
+	hashAndMapToG2(z, m, size);
+}
+template<class T>
+inline void hashAndMapToG(T& z, const void *m, mclSize size) { hashAndMapToG(g_ctx, z, m, size); }
+
+/*
+	out[i] = hashAndMapToG(msgs[i]) for i = 0, ..., n-1
+	the SHA-256 of expand_message_xmd for many messages runs at once if useExpand = useExpandMsg(ctx, ...)
+*/
+template<class Msgs>
+void hashAndMapToGVec(const Context& ctx, G *out, const Msgs& msgs, mclSize n, bool useExpand)
+{
+#ifdef BLS_ETH
+	if (useExpand) {
+		const size_t N = 16;
+		uint8_t md[N * 256];
+		size_t pos = 0;
+		while (pos < n) {
+			size_t m = fp::min_<size_t>(n - pos, N);
+			BLS_STAT_SCOPE(BLS_STAT_HASH_TO_CURVE, m);
+			BLS_TRACE_SCOPE(BLS_PHASE_HASH, m);
+			ctx.expandMsg.expandVec(md, 256, msgs.skip(pos), m);
+			for (size_t i = 0; i < m; i++) {
+				mapToGfromExpandedMsg(out[pos + i], md + 256 * i);
+			}
+			pos += m;
+		}
+		return;
+	}
+#else
+	(void)useExpand;
+#endif
+	for (size_t i = 0; i < n; i++) {
+		hashAndMapToG(ctx, out[i], msgs.get(i), msgs.getSize(i));
+	}
+}
+
 int blsSetETHmode(int mode)
 {
 	if (g_curveType != MCL_BLS12_381) return -1;
@@ -79,7 +368,42 @@ int blsSetETHmode(int mode)
 
 int blsSetMapToMode(int mode)
 {
-	return mclBn_setMapToMode(mode);
+	if (mclBn_setMapToMode(mode) != 0) return -1;
+#ifdef BLS_ETH
+	// mcl may reset DST to the default one
+	if (!updateGlobalDst(g_mclDst, g_mclDstSize)) {
+		updateGlobalDst(g_defaultDst, strlen(g_defaultDst));
+	}
+#endif
+	return 0;
+}
+
+int blsSetDst(const char *dst, mclSize dstSize)
+{
+#ifdef BLS_ETH
+	if (mclBnG2_setDst(dst, dstSize) != 0) return -1;
+	setGlobalDst(dst, dstSize);
+	return 0;
+#else
+	return mclBnG1_setDst(dst, dstSize) == 0 ? 0 : -1;
+#endif
+}
+
+/*
+	a random key of the fingerprints for blsAreAllMsgDifferent and blsAggregateVerify
+	nobody can make many messages of the same fingerprint without it
+*/
+void initMsgFpKey()
+{
+#ifndef MCL_DONT_USE_CSPRNG
+	Fr r;
+	bool b;
+	r.setByCSPRNG(&b);
+	if (!b) return;
+	uint64_t k[2];
+	memcpy(k, r.getUnit(), sizeof(k));
+	bls_util::setMsgFpKey(k[0], k[1]);
+#endif
 }
 
 int blsInit(int curve, int compiledTimeVar)
@@ -100,32 +424,46 @@ int blsInit(int curve, int compiledTimeVar)
 #ifdef BLS_ETH
 	if (curve == MCL_BLS12_381) {
 		mclBn_setETHserialization(1);
-		g_P.setStr(&b, "1 3685416753713387016781088315183077757961620795782546409894578378688607592378376318836054947676345821548104185464507 1339506544944476473020471379941921221584933875938349620426543736416511423956333506472724655353366534992391756441569", 10);
+#ifdef BLS_USE_PRECOMPUTED_TBL
+		if (hasPrecomputedTbl()) {
+			getPrecomputedGen(g_ctx.gen);
+		} else
+#endif
+		{
+			g_ctx.gen.setStr(&b, "1 3685416753713387016781088315183077757961620795782546409894578378688607592378376318836054947676345821548104185464507 1339506544944476473020471379941921221584933875938349620426543736416511423956333506472724655353366534992391756441569", 10);
+		}
 		mclBn_setMapToMode(MCL_MAP_TO_MODE_HASH_TO_CURVE_07);
 		blsSetETHmode(BLS_ETH_MODE_LATEST);
 	} else
 	{
-		mapToG1(&b, g_P, 1);
+		mapToG1(&b, g_ctx.gen, 1);
 	}
+	setGlobalDst(g_defaultDst, strlen(g_defaultDst));
 #else
 
 	if (curve == MCL_BN254) {
 		const char *Qx_BN254 = "11ccb44e77ac2c5dc32a6009594dbe331ec85a61290d6bbac8cc7ebb2dceb128 f204a14bbdac4a05be9a25176de827f2e60085668becdd4fc5fa914c9ee0d9a";
 		const char *Qy_BN254 = "7c13d8487903ee3c1c5ea327a3a52b6cc74796b1760d5ba20ed802624ed19c8 8f9642bbaacb73d8c89492528f58932f2de9ac3e80c7b0e41f1a84f1c40182";
-		g_Q.x.setStr(&b, Qx_BN254, 16);
-		g_Q.y.setStr(&b, Qy_BN254, 16);
-		g_Q.z = 1;
-	} else {
-		mapToG2(&b, g_Q, 1);
+		g_ctx.gen.x.setStr(&b, Qx_BN254, 16);
+		g_ctx.gen.y.setStr(&b, Qy_BN254, 16);
+		g_ctx.gen.z = 1;
+	} else
+#ifdef BLS_USE_PRECOMPUTED_TBL
+	if (hasPrecomputedTbl()) {
+		getPrecomputedGen(g_ctx.gen);
+	} else
+#endif
+	{
+		mapToG2(&b, g_ctx.gen, 1);
 	}
 	if (!b) return -100;
 #if MCL_SIZEOF_UNIT == 8
 	if (curve == MCL_BN254) {
 		#include "./qcoeff-bn254.hpp"
-		g_Qcoeff.resize(getPrecomputedQcoeffSize());
-		assert(g_Qcoeff.size() == CYBOZU_NUM_OF_ARRAY(QcoeffTblBN254));
-		for (size_t i = 0; i < g_Qcoeff.size(); i++) {
-			Fp6& x6 = g_Qcoeff[i];
+		g_ctx.Qcoeff.resize(getPrecomputedQcoeffSize());
+		assert(g_ctx.Qcoeff.size() == CYBOZU_NUM_OF_ARRAY(QcoeffTblBN254));
+		for (size_t i = 0; i < g_ctx.Qcoeff.size(); i++) {
+			Fp6& x6 = g_ctx.Qcoeff[i];
 			for (size_t j = 0; j < 6; j++) {
 				Fp& x = x6.getFp0()[j];
 				Unit *p = const_cast<Unit*>(x.getUnit());
@@ -135,12 +473,26 @@ int blsInit(int curve, int compiledTimeVar)
 			}
 		}
 	} else
+#endif
+#ifdef BLS_USE_PRECOMPUTED_TBL
+	if (hasPrecomputedTbl()) {
+		g_ctx.Qcoeff.resize(getPrecomputedQcoeffSize());
+		assert(g_ctx.Qcoeff.size() == CYBOZU_NUM_OF_ARRAY(QcoeffTblBLS12_381));
+		for (size_t i = 0; i < g_ctx.Qcoeff.size(); i++) {
+			Fp6& x6 = g_ctx.Qcoeff[i];
+			for (size_t j = 0; j < 6; j++) {
+				setPrecomputedFp(x6.getFp0()[j], QcoeffTblBLS12_381[i][j]);
+			}
+		}
+	} else
 #endif
 	{
-		precomputeG2(&b, g_Qcoeff, getBasePoint());
+		precomputeG2(&b, g_ctx.Qcoeff, getBasePoint());
 	}
 #endif
 	if (!b) return -101;
+	if (!updateGenTbl()) return -102;
+	initMsgFpKey();
 	verifyOrderG1(true);
 	verifyOrderG2(true);
 	return 0;
@@ -184,6 +536,11 @@ int blsSecretKeySetLittleEndianMod(blsSecretKey *sec, const void *buf, mclSize b
 
 void blsGetPublicKey(blsPublicKey *pub, const blsSecretKey *sec)
 {
+	if (g_genTbl.isInitialized()) {
+		BLS_STAT_SCOPE(BLS_STAT_MUL, 1);
+		g_genTbl.mul(*cast(&pub->v), *cast(&sec->v));
+		return;
+	}
 	Gmul(*cast(&pub->v), getBasePoint(), *cast(&sec->v));
 }
 
@@ -193,11 +550,16 @@ int blsHashToSignature(blsSignature *sig, const void *buf, mclSize bufSize)
 	return 0;
 }
 
+void blsSignHashedPoint(blsSignature *sig, const blsSecretKey *sec, const blsSignature *Hm)
+{
+	Fr s = *cast(&sec->v);
+	GmulCT(*cast(&sig->v), *cast(&Hm->v), s);
+}
+
 void blsSign(blsSignature *sig, const blsSecretKey *sec, const void *m, mclSize size)
 {
 	blsHashToSignature(sig, m, size);
-	Fr s = *cast(&sec->v);
-	GmulCT(*cast(&sig->v), *cast(&sig->v), s);
+	blsSignHashedPoint(sig, sec, sig);
 }
 
 #ifdef BLS_ETH
@@ -205,15 +567,15 @@ void blsSign(blsSignature *sig, const blsSecretKey *sec, const void *m, mclSize
 	e(P, sHm) == e(sP, Hm)
 	<=> finalExp(ML(P, sHm) * ML(-sP, Hm)) == 1
 */
-bool isEqualTwoPairings(const G2& sHm, const G1& sP, const G2& Hm)
+bool isEqualTwoPairings(const G1& P, const G2& sHm, const G1& sP, const G2& Hm)
 {
 	GT e;
 	G1 v1[2];
 	G2 v2[2] = { sHm, Hm };
-	v1[0] = getBasePoint();
+	v1[0] = P;
 	G1::neg(v1[1], sP);
-	millerLoopVec(e, v1, v2, 2);
-	finalExp(e, e);
+	statMillerLoopVec(e, v1, v2, 2);
+	statFinalExp(e, e);
 	return e.isOne();
 }
 #else
@@ -227,31 +589,154 @@ bool isEqualTwoPairings(const G2& sHm, const G1& sP, const G2& Hm)
 bool isEqualTwoPairings(const G1& P1, const Fp6* Q1coeff, const G1& P2, const G2& Q2)
 {
 	GT e;
-	precomputedMillerLoop2mixed(e, P2, Q2, -P1, Q1coeff);
-	finalExp(e, e);
+	statPrecomputedMillerLoop2mixed(e, P2, Q2, -P1, Q1coeff);
+	statFinalExp(e, e);
 	return e.isOne();
 }
 #endif
 
-int blsVerify(const blsSignature *sig, const blsPublicKey *pub, const void *m, mclSize size)
+// verify sig for the hashed message Hm
+bool verifyHashed(const Context& ctx, const G& sig, const Gother& pub, const G& Hm)
 {
-	if (cast(&pub->v)->isZero()) return 0;
-	G Hm;
-	hashAndMapToG(Hm, m, size);
 #ifdef BLS_ETH
-	return isEqualTwoPairings(*cast(&sig->v), *cast(&pub->v), Hm);
+	return isEqualTwoPairings(ctx.gen, sig, pub, Hm);
 #else
 	/*
 		e(sHm, Q) = e(Hm, sQ)
 		e(sig, Q) = e(Hm, pub)
 	*/
-	return isEqualTwoPairings(*cast(&sig->v), getQcoeff().data(), Hm, *cast(&pub->v));
+	return isEqualTwoPairings(sig, ctx.Qcoeff.data(), Hm, pub);
 #endif
 }
 
-void blsMultiVerifySub(mclBnGT *e, blsSignature *aggSig, blsSignature *sigVec, const blsPublicKey *pubVec, const char *msg, mclSize msgSize, const char *randVec, mclSize randSize, mclSize n)
+int verify(const Context& ctx, const blsSignature *sig, const blsPublicKey *pub, const void *m, mclSize size)
+{
+	if (cast(&pub->v)->isZero()) return 0;
+	G Hm;
+	hashAndMapToG(ctx, Hm, m, size);
+	return verifyHashed(ctx, *cast(&sig->v), *cast(&pub->v), Hm);
+}
+
+int blsVerify(const blsSignature *sig, const blsPublicKey *pub, const void *m, mclSize size)
+{
+	return verify(g_ctx, sig, pub, m, size);
+}
+
+typedef bls_util::FixedSizeMsg FixedSizeMsg;
+typedef bls_util::VarSizeMsgT<mclSize> VarSizeMsg;
+
+#ifdef BLS_MULTI_VERIFY_THREAD
+template<class Msgs>
+void setMsgEntryVecThread(uint64_t *e, Msgs msgs, size_t n, size_t offset)
+{
+	BLS_TRACE_SCOPE(BLS_PHASE_WORKER, n);
+	bls_util::setMsgEntryVec(e, msgs, n, offset);
+}
+
+template<class Msgs>
+void checkMsgBucketRangeThread(bool *ret, Msgs msgs, uint64_t *e, const size_t *pos, size_t begin, size_t end)
+{
+	BLS_TRACE_SCOPE(BLS_PHASE_WORKER, pos[end] - pos[begin]);
+	*ret = bls_util::checkMsgBucketRange(msgs, e, pos, begin, end);
+}
+
+template<class Msgs>
+void checkMsgPartRangeThread(bool *ret, Msgs msgs, size_t n, int bits, uint64_t begin, uint64_t end)
+{
+	BLS_TRACE_SCOPE(BLS_PHASE_WORKER, n);
+	*ret = bls_util::checkMsgPartRange(msgs, n, bits, begin, end);
+}
+
+template<class Msgs>
+void checkAllMsgDifferentThread(bool *ret, Msgs msgs, size_t n)
+{
+	BLS_TRACE_SCOPE(BLS_PHASE_WORKER, n);
+	*ret = bls_util::checkAllMsgDifferent(msgs, n);
+}
+#endif
+
+/*
+	bls_util::checkAllMsgDifferent with threadN threads
+	the entries are made in parallel in buf[0, 8n) and the buckets of them are split into the threads
+	the parts of the messages are split into the threads if buf is too small
+*/
+template<class Msgs>
+bool checkAllMsgDifferentMT(const Msgs& msgs, size_t n, void *buf, size_t bufSize, int threadN)
+{
+#ifdef BLS_MULTI_VERIFY_THREAD
+	const int maxThreadNum = 32;
+	if (threadN > maxThreadNum) threadN = maxThreadNum;
+	const size_t minN = 4096;
+	if (threadN > 1 && n >= minN && uint64_t(n) < 0xffffffffull) {
+		std::thread th[maxThreadNum];
+		bool ret[maxThreadNum];
+		bool differ = true;
+		uint64_t *e = bls_util::getMsgEntryBuf(buf, bufSize, n);
+		if (e == 0) {
+			const int bits = bls_util::getMsgPartBits(n);
+			const uint64_t partN = uint64_t(1) << bits;
+			if (uint64_t(threadN) > partN) threadN = int(partN);
+			uint64_t begin = 0;
+			for (int i = 0; i < threadN; i++) {
+				const uint64_t end = partN * (i + 1) / threadN;
+				th[i] = std::thread(checkMsgPartRangeThread<Msgs>, &ret[i], msgs, n, bits, begin, end);
+				begin = end;
+			}
+			for (int i = 0; i < threadN; i++) {
+				th[i].join();
+				differ = differ && ret[i];
+			}
+			return differ;
+		}
+		size_t pos = 0;
+		for (int i = 0; i < threadN; i++) {
+			const size_t m = n * (i + 1) / threadN - pos;
+			th[i] = std::thread(setMsgEntryVecThread<Msgs>, e + pos, msgs.skip(pos), m, pos);
+			pos += m;
+		}
+		for (int i = 0; i < threadN; i++) {
+			th[i].join();
+		}
+		size_t bucketPos[bls_util::msgBucketN + 1];
+		bls_util::distributeMsgEntry(e, n, bucketPos);
+		size_t begin = 0;
+		for (int i = 0; i < threadN; i++) {
+			// split the buckets so that each thread has about n / threadN entries
+			const size_t goal = n * (i + 1) / threadN;
+			size_t end = begin;
+			while (end < bls_util::msgBucketN && bucketPos[end] < goal) end++;
+			if (i == threadN - 1) end = bls_util::msgBucketN;
+			th[i] = std::thread(checkMsgBucketRangeThread<Msgs>, &ret[i], msgs, e, bucketPos, begin, end);
+			begin = end;
+		}
+		for (int i = 0; i < threadN; i++) {
+			th[i].join();
+			differ = differ && ret[i];
+		}
+		return differ;
+	}
+#else
+	(void)threadN;
+#endif
+	return bls_util::checkAllMsgDifferent(msgs, n, buf, bufSize);
+}
+
+int blsAreAllMsgDifferent(const void *msgVec, mclSize msgSize, mclSize n, void *buf, mclSize bufSize, int threadN)
+{
+	return checkAllMsgDifferentMT(FixedSizeMsg(msgVec, msgSize), n, buf, bufSize, threadN) ? 1 : 0;
+}
+
+int blsAreAllMsgDifferentVarLen(const void *msgVec, const mclSize *msgOffsetVec, mclSize n, void *buf, mclSize bufSize, int threadN)
 {
+	return checkAllMsgDifferentMT(VarSizeMsg(msgVec, msgOffsetVec), n, buf, bufSize, threadN) ? 1 : 0;
+}
+
 #ifdef BLS_ETH
+template<class Msgs>
+void multiVerifySub(mclBnGT *e, blsSignature *aggSig, blsSignature *sigVec, const blsPublicKey *pubVec, Msgs msgs, const char *randVec, mclSize randSize, mclSize n)
+{
+	BLS_TRACE_SCOPE(BLS_PHASE_WORKER, n);
+	const bool useExpand = useExpandMsg(g_ctx, n);
 	const size_t N = 16;
 	Fr rand[N];
 	G1 g1Vec[N];
@@ -259,33 +744,43 @@ void blsMultiVerifySub(mclBnGT *e, blsSignature *aggSig, blsSignature *sigVec, c
 	bool initE = true;
 	while (n > 0) {
 		size_t m = fp::min_<size_t>(n, N);
-		for (size_t i = 0; i < m; i++) {
-			bool b;
-			rand[i].setArray(&b, (const uint8_t *)&randVec[i * randSize], randSize);
-			(void)b;
-			const G1& pub = *cast(&pubVec[i].v);
-			if (pub.isZero()) {
-				cast(e)->clear();
-				return;
+		{
+			BLS_TRACE_SCOPE(BLS_PHASE_MUL, m);
+			for (size_t i = 0; i < m; i++) {
+				bool b;
+				rand[i].setArray(&b, (const uint8_t *)&randVec[i * randSize], randSize);
+				(void)b;
+				const G1& pub = *cast(&pubVec[i].v);
+				if (pub.isZero()) {
+					cast(e)->clear();
+					return;
+				}
+				Gmul(g1Vec[i], pub, rand[i]);
 			}
-			G1::mul(g1Vec[i], pub, rand[i]);
-			hashAndMapToG(g2Vec[i], &msg[i * msgSize], msgSize);
 		}
+		hashAndMapToGVec(g_ctx, g2Vec, msgs, m, useExpand);
 		if (initE) {
-			G2::mulVec(*cast(&aggSig->v), cast(&sigVec->v), rand, m);
+			GmulVec(*cast(&aggSig->v), cast(&sigVec->v), rand, m);
 		} else {
 			G2 t;
-			G2::mulVec(t, cast(&sigVec->v), rand, m);
+			GmulVec(t, cast(&sigVec->v), rand, m);
 			*cast(&aggSig->v) += t;
 		}
 		sigVec += m;
 		pubVec += m;
-		msg += m * msgSize;
+		msgs = msgs.skip(m);
 		randVec += m * randSize;
 		n -= m;
-		millerLoopVec(*cast(e), g1Vec, g2Vec, m, initE);
+		statMillerLoopVec(*cast(e), g1Vec, g2Vec, m, initE);
 		initE = false;
 	}
+}
+#endif
+
+void blsMultiVerifySub(mclBnGT *e, blsSignature *aggSig, blsSignature *sigVec, const blsPublicKey *pubVec, const char *msg, mclSize msgSize, const char *randVec, mclSize randSize, mclSize n)
+{
+#ifdef BLS_ETH
+	multiVerifySub(e, aggSig, sigVec, pubVec, FixedSizeMsg(msg, msgSize), randVec, randSize, n);
 #else
 	(void)e;
 	(void)aggSig;
@@ -299,14 +794,31 @@ void blsMultiVerifySub(mclBnGT *e, blsSignature *aggSig, blsSignature *sigVec, c
 #endif
 }
 
+void blsMultiVerifySubVarLen(mclBnGT *e, blsSignature *aggSig, blsSignature *sigVec, const blsPublicKey *pubVec, const char *msgVec, const mclSize *msgOffsetVec, const char *randVec, mclSize randSize, mclSize n)
+{
+#ifdef BLS_ETH
+	multiVerifySub(e, aggSig, sigVec, pubVec, VarSizeMsg(msgVec, msgOffsetVec), randVec, randSize, n);
+#else
+	(void)e;
+	(void)aggSig;
+	(void)sigVec;
+	(void)pubVec;
+	(void)msgVec;
+	(void)msgOffsetVec;
+	(void)randVec;
+	(void)randSize;
+	(void)n;
+#endif
+}
+
 int blsMultiVerifyFinal(const mclBnGT *e, const blsSignature *aggSig)
 {
 #ifdef BLS_ETH
 	if (cast(e)->isZero()) return false;
 	GT e2;
-	millerLoop(e2, -getBasePoint(), *cast(&aggSig->v));
+	statMillerLoop(e2, -getBasePoint(), *cast(&aggSig->v));
 	e2 *= *cast(e);
-	finalExp(e2, e2);
+	statFinalExp(e2, e2);
 	return e2.isOne();
 #else
 	(void)e;
@@ -314,17 +826,12 @@ int blsMultiVerifyFinal(const mclBnGT *e, const blsSignature *aggSig)
 	return 0;
 #endif
 }
-/*
-	sig = sum_i sigVec[i] * randVec[i]
-	pubVec[i] *= randVec[i]
-	verify prod e(H(pubVec[i], msgToG2[i]) == e(P, sig)
-	@remark return 0 if some pubVec[i] is zero
-*/
-int blsMultiVerify(blsSignature *sigVec, const blsPublicKey *pubVec, const void *msgVec, mclSize msgSize, const void *randVec, mclSize randSize, mclSize n, int threadN)
-{
 #ifdef BLS_ETH
+template<class Msgs>
+int multiVerify(blsSignature *sigVec, const blsPublicKey *pubVec, Msgs msgs, const void *randVec, mclSize randSize, mclSize n, int threadN)
+{
 	if (n == 0) return 0;
-	const char *msg = (const char*)msgVec;
+	BLS_TRACE_SCOPE(BLS_PHASE_BATCH, n);
 	const char *rp = (const char*)randVec;
 	GT e;
 	G2 aggSig;
@@ -356,15 +863,18 @@ int blsMultiVerify(blsSignature *sigVec, const blsPublicKey *pubVec, const void
 			if (i == threadN - 1) {
 				m = n;
 			}
-			th[i] = std::thread(blsMultiVerifySub, (mclBnGT*)&et[i], (blsSignature*)&aggSigt[i], sigVec, pubVec, msg, msgSize, rp, randSize, m);
+			th[i] = std::thread(multiVerifySub<Msgs>, (mclBnGT*)&et[i], (blsSignature*)&aggSigt[i], sigVec, pubVec, msgs, rp, randSize, m);
 			sigVec += m;
 			pubVec += m;
-			msg += msgSize * m;
+			msgs = msgs.skip(m);
 			rp += randSize * m;
 			n -= m;
 		}
-		for (int i = 0; i < threadN; i++) {
-			th[i].join();
+		{
+			BLS_TRACE_SCOPE(BLS_PHASE_JOIN, threadN);
+			for (int i = 0; i < threadN; i++) {
+				th[i].join();
+			}
 		}
 		e = et[0];
 		aggSig = aggSigt[0];
@@ -375,20 +885,50 @@ int blsMultiVerify(blsSignature *sigVec, const blsPublicKey *pubVec, const void
 	} else
 #endif
 	{
-		blsMultiVerifySub((mclBnGT*)&e, (blsSignature*)&aggSig, sigVec, pubVec, msg, msgSize, rp, randSize, n);
+		multiVerifySub((mclBnGT*)&e, (blsSignature*)&aggSig, sigVec, pubVec, msgs, rp, randSize, n);
 	}
 	return blsMultiVerifyFinal((const mclBnGT*)&e, (const blsSignature*)&aggSig);
-#else
-	(void)sigVec;
-	(void)pubVec;
-	(void)msgVec;
-	(void)msgSize;
-	(void)randVec;
-	(void)randSize;
-	(void)n;
-	(void)threadN;
-	return 0;
-#endif
+}
+#endif
+
+/*
+	sig = sum_i sigVec[i] * randVec[i]
+	pubVec[i] *= randVec[i]
+	verify prod e(H(pubVec[i], msgToG2[i]) == e(P, sig)
+	@remark return 0 if some pubVec[i] is zero
+*/
+int blsMultiVerify(blsSignature *sigVec, const blsPublicKey *pubVec, const void *msgVec, mclSize msgSize, const void *randVec, mclSize randSize, mclSize n, int threadN)
+{
+#ifdef BLS_ETH
+	return multiVerify(sigVec, pubVec, FixedSizeMsg(msgVec, msgSize), randVec, randSize, n, threadN);
+#else
+	(void)sigVec;
+	(void)pubVec;
+	(void)msgVec;
+	(void)msgSize;
+	(void)randVec;
+	(void)randSize;
+	(void)n;
+	(void)threadN;
+	return 0;
+#endif
+}
+
+int blsMultiVerifyVarLen(blsSignature *sigVec, const blsPublicKey *pubVec, const void *msgVec, const mclSize *msgOffsetVec, const void *randVec, mclSize randSize, mclSize n, int threadN)
+{
+#ifdef BLS_ETH
+	return multiVerify(sigVec, pubVec, VarSizeMsg(msgVec, msgOffsetVec), randVec, randSize, n, threadN);
+#else
+	(void)sigVec;
+	(void)pubVec;
+	(void)msgVec;
+	(void)msgOffsetVec;
+	(void)randVec;
+	(void)randSize;
+	(void)n;
+	(void)threadN;
+	return 0;
+#endif
 }
 
 void blsAggregateSignature(blsSignature *aggSig, const blsSignature *sigVec, mclSize n)
@@ -420,22 +960,29 @@ int blsAggregatePublicKey(blsPublicKey *aggPub, const blsPublicKey *pubVec, mclS
 	return ret;
 }
 
-int blsFastAggregateVerify(const blsSignature *sig, const blsPublicKey *pubVec, mclSize n, const void *msg, mclSize msgSize)
+int fastAggregateVerify(const Context& ctx, const blsSignature *sig, const blsPublicKey *pubVec, mclSize n, const void *msg, mclSize msgSize)
 {
 	if (n == 0) return 0;
+	BLS_TRACE_SCOPE(BLS_PHASE_BATCH, n);
 	blsPublicKey aggPub;
 	int ret = blsAggregatePublicKey(&aggPub, pubVec, n);
 	if (ret < 0) return 0;
-	return blsVerify(sig, &aggPub, msg, msgSize);
+	return verify(ctx, sig, &aggPub, msg, msgSize);
 }
 
-int blsAggregateVerifyNoCheck(const blsSignature *sig, const blsPublicKey *pubVec, const void *msgVec, mclSize msgSize, mclSize n)
+int blsFastAggregateVerify(const blsSignature *sig, const blsPublicKey *pubVec, mclSize n, const void *msg, mclSize msgSize)
 {
+	return fastAggregateVerify(g_ctx, sig, pubVec, n, msg, msgSize);
+}
+
 #ifdef BLS_ETH
-	if (n == 0) return 0;
+// aggregateVerifyNoCheck without the trace scope of the batch for n > 0
+template<class Msgs>
+int aggregateVerifyNoCheckSub(const Context& ctx, const blsSignature *sig, const blsPublicKey *pubVec, Msgs msgs, mclSize n)
+{
 #if 1 // 1.1 times faster
+	const bool useExpand = useExpandMsg(ctx, n);
 	GT e;
-	const char *msg = (const char*)msgVec;
 	const size_t N = 16;
 	G1 g1Vec[N+1];
 	G2 g2Vec[N+1];
@@ -446,36 +993,103 @@ int blsAggregateVerifyNoCheck(const blsSignature *sig, const blsPublicKey *pubVe
 		for (size_t i = 0; i < m; i++) {
 			g1Vec[i] = *cast(&pubVec[i].v);
 			if (g1Vec[i].isZero()) return 0;
-			hashAndMapToG(g2Vec[i], &msg[i * msgSize], msgSize);
 		}
+		hashAndMapToGVec(ctx, g2Vec, msgs, m, useExpand);
 		pubVec += m;
-		msg += m * msgSize;
+		msgs = msgs.skip(m);
 		n -= m;
 		if (n == 0) {
-			g1Vec[m] = getBasePoint();
+			g1Vec[m] = ctx.gen;
 			G2::neg(g2Vec[m], *cast(&sig->v));
 			m++;
 		}
-		millerLoopVec(e, g1Vec, g2Vec, m, initE);
+		statMillerLoopVec(e, g1Vec, g2Vec, m, initE);
 		initE = false;
 	}
-	finalExp(e, e);
+	statFinalExp(e, e);
 	return e.isOne();
 #else
-	const char *p = (const char *)msgVec;
 	GT s(1), t;
 	for (mclSize i = 0; i < n; i++) {
 		G2 Q;
-		hashAndMapToG(Q, &p[msgSize * i], msgSize);
+		hashAndMapToG(ctx, Q, msgs.get(i), msgs.getSize(i));
 		if (cast(&pubVec[i].v)->isZero()) return 0;
-		millerLoop(t, *cast(&pubVec[i].v), Q);
+		statMillerLoop(t, *cast(&pubVec[i].v), Q);
 		s *= t;
 	}
-	millerLoop(t, -getBasePoint(), *cast(&sig->v));
+	statMillerLoop(t, -ctx.gen, *cast(&sig->v));
 	s *= t;
-	finalExp(s, s);
+	statFinalExp(s, s);
 	return s.isOne() ? 1 : 0;
 #endif
+}
+
+template<class Msgs>
+int aggregateVerifyNoCheck(const Context& ctx, const blsSignature *sig, const blsPublicKey *pubVec, Msgs msgs, mclSize n)
+{
+	if (n == 0) return 0;
+	BLS_TRACE_SCOPE(BLS_PHASE_BATCH, n);
+	return aggregateVerifyNoCheckSub(ctx, sig, pubVec, msgs, n);
+}
+
+// the batch scope covers the check of the messages and the join of its thread
+template<class Msgs>
+int aggregateVerify(const Context& ctx, const blsSignature *sig, const blsPublicKey *pubVec, Msgs msgs, mclSize n)
+{
+	if (n == 0) return 0;
+	BLS_TRACE_SCOPE(BLS_PHASE_BATCH, n);
+#ifdef BLS_MULTI_VERIFY_THREAD
+	/*
+		the check is much cheaper than hashAndMapToG2,
+		so run it in another thread only if it costs more than creating a thread
+	*/
+	const size_t minN = 4096;
+	if (n >= minN) {
+		bool differ = false;
+		std::thread th(checkAllMsgDifferentThread<Msgs>, &differ, msgs, size_t(n));
+		int ret = aggregateVerifyNoCheckSub(ctx, sig, pubVec, msgs, n);
+		BLS_TRACE_SCOPE(BLS_PHASE_JOIN, 1);
+		th.join();
+		return differ ? ret : 0;
+	}
+#endif
+	if (!bls_util::checkAllMsgDifferent(msgs, n)) return 0;
+	return aggregateVerifyNoCheckSub(ctx, sig, pubVec, msgs, n);
+}
+#endif
+
+int blsAggregateVerify(const blsSignature *sig, const blsPublicKey *pubVec, const void *msgVec, mclSize msgSize, mclSize n)
+{
+#ifdef BLS_ETH
+	return aggregateVerify(g_ctx, sig, pubVec, FixedSizeMsg(msgVec, msgSize), n);
+#else
+	(void)sig;
+	(void)pubVec;
+	(void)msgVec;
+	(void)msgSize;
+	(void)n;
+	return 0;
+#endif
+}
+
+int blsAggregateVerifyVarLen(const blsSignature *sig, const blsPublicKey *pubVec, const void *msgVec, const mclSize *msgOffsetVec, mclSize n)
+{
+#ifdef BLS_ETH
+	return aggregateVerify(g_ctx, sig, pubVec, VarSizeMsg(msgVec, msgOffsetVec), n);
+#else
+	(void)sig;
+	(void)pubVec;
+	(void)msgVec;
+	(void)msgOffsetVec;
+	(void)n;
+	return 0;
+#endif
+}
+
+int blsAggregateVerifyNoCheck(const blsSignature *sig, const blsPublicKey *pubVec, const void *msgVec, mclSize msgSize, mclSize n)
+{
+#ifdef BLS_ETH
+	return aggregateVerifyNoCheck(g_ctx, sig, pubVec, FixedSizeMsg(msgVec, msgSize), n);
 #else
 	(void)sig;
 	(void)pubVec;
@@ -486,6 +1100,20 @@ int blsAggregateVerifyNoCheck(const blsSignature *sig, const blsPublicKey *pubVe
 #endif
 }
 
+int blsAggregateVerifyNoCheckVarLen(const blsSignature *sig, const blsPublicKey *pubVec, const void *msgVec, const mclSize *msgOffsetVec, mclSize n)
+{
+#ifdef BLS_ETH
+	return aggregateVerifyNoCheck(g_ctx, sig, pubVec, VarSizeMsg(msgVec, msgOffsetVec), n);
+#else
+	(void)sig;
+	(void)pubVec;
+	(void)msgVec;
+	(void)msgOffsetVec;
+	(void)n;
+	return 0;
+#endif
+}
+
 mclSize blsIdSerialize(void *buf, mclSize maxBufSize, const blsId *id)
 {
 	return cast(&id->v)->serialize(buf, maxBufSize);
@@ -518,11 +1146,13 @@ mclSize blsSecretKeyDeserialize(blsSecretKey *sec, const void *buf, mclSize bufS
 
 mclSize blsPublicKeyDeserialize(blsPublicKey *pub, const void *buf, mclSize bufSize)
 {
+	BLS_STAT_SCOPE(BLS_STAT_DESERIALIZE, 1);
 	return cast(&pub->v)->deserialize(buf, bufSize);
 }
 
 mclSize blsSignatureDeserialize(blsSignature *sig, const void *buf, mclSize bufSize)
 {
+	BLS_STAT_SCOPE(BLS_STAT_DESERIALIZE, 1);
 	return cast(&sig->v)->deserialize(buf, bufSize);
 }
 
@@ -580,25 +1210,258 @@ int blsPublicKeyShare(blsPublicKey *pub, const blsPublicKey *mpk, mclSize k, con
 	return b ? 0 : -1;
 }
 
-int blsSecretKeyRecover(blsSecretKey *sec, const blsSecretKey *secVec, const blsId *idVec, mclSize n)
+/*
+	the number of the Lagrange coefficients computed at once by recoverSub
+	the points of a chunk are on the stack
+*/
+#if defined(__EMSCRIPTEN__) || defined(__wasm__)
+const size_t lagrangeChunkN = 32;
+#else
+const size_t lagrangeChunkN = 256;
+#endif
+
+// return true if S[i] = S[0] + i for i in [0, n) such as the ids set by blsIdSetInt(1, 2, ...)
+inline bool isConsecutive(const Fr *S, size_t n)
+{
+	const Fr one = 1;
+	for (size_t i = 1; i < n; i++) {
+		if (S[i] != S[i - 1] + one) return false;
+	}
+	return true;
+}
+
+/*
+	the Lagrange coefficients L_i for S[i] = a + i (i in [0, n)) in order of i
+	L_i = prod_{j != i} (a + j) / (j - i) = P (-1)^i / ((a + i) i! (n - 1 - i)!) where P = prod_j (a + j)
+	the state at i ; y = a + i, f = i!, g = 1 / (n - 1 - i)!, r = n - 1 - i
+	init costs O(n) and getVec costs O(m) with one inversion, so all of them cost O(n)
+*/
+class LagrangeCoeffConsecutive {
+	Fr P_, y_, f_, g_, i_, r_;
+	size_t pos_;
+	// move to i + 1
+	void next()
+	{
+		const Fr one = 1;
+		g_ *= r_;
+		r_ -= one;
+		i_ += one;
+		f_ *= i_;
+		y_ += one;
+		pos_++;
+	}
+public:
+	// set the state at begin ; return false if some a + i is zero
+	bool init(const Fr& a, size_t n, size_t begin)
+	{
+		const Fr one = 1;
+		Fr y = a;
+		Fr k = 0;
+		P_ = 1;
+		g_ = 1;
+		for (size_t j = 0; j < n; j++) {
+			P_ *= y;
+			y += one;
+			if (j > 0) {
+				k += one;
+				g_ *= k;
+			}
+		}
+		if (P_.isZero()) return false;
+		Fr::inv(g_, g_);
+		y_ = a;
+		f_ = 1;
+		i_ = 0;
+		r_ = k;
+		pos_ = 0;
+		for (size_t j = 0; j < begin; j++) next();
+		return true;
+	}
+	// c[j] = L_{i + j} for j in [0, m) where 0 < m <= lagrangeChunkN, and move to i + m
+	void getVec(Fr *c, size_t m)
+	{
+		Fr b[lagrangeChunkN];
+		Fr g[lagrangeChunkN];
+		const size_t begin = pos_;
+		for (size_t j = 0; j < m; j++) {
+			// b[j] = (a + i) i!
+			b[j] = y_ * f_;
+			g[j] = g_;
+			c[j] = j == 0 ? b[0] : c[j - 1] * b[j];
+			next();
+		}
+		Fr inv;
+		Fr::inv(inv, c[m - 1]);
+		inv *= P_;
+		for (size_t j = m - 1; j > 0; j--) {
+			c[j] = inv * c[j - 1];
+			inv *= b[j];
+		}
+		c[0] = inv;
+		for (size_t j = 0; j < m; j++) {
+			c[j] *= g[j];
+			if ((begin + j) & 1) Fr::neg(c[j], c[j]);
+		}
+	}
+};
+
+/*
+	c[i] = L_{idx[i]} for i in [0, m) where m <= lagrangeChunkN
+	L_i = prod_{j != i} S[j] / (S[j] - S[i]) = a / b_i
+	where a = prod_j S[j], b_i = S[i] prod_{j != i} (S[j] - S[i])
+	j runs over [0, n) such that mask[j] == 1 (all of them if mask is NULL)
+	1 / b_i are computed by one inversion (Montgomery's trick)
+	return false if S has zero or the same values
+*/
+inline bool getLagrangeCoeffVec(Fr *c, const Fr *S, const uint8_t *mask, size_t n, const size_t *idx, size_t m)
+{
+	Fr a = 1;
+	for (size_t j = 0; j < n; j++) {
+		if (mask && mask[j] != 1) continue;
+		a *= S[j];
+	}
+	if (a.isZero()) return false;
+	Fr b[lagrangeChunkN];
+	for (size_t i = 0; i < m; i++) {
+		const Fr& x = S[idx[i]];
+		Fr t = x;
+		for (size_t j = 0; j < n; j++) {
+			if (j == idx[i] || (mask && mask[j] != 1)) continue;
+			Fr v = S[j] - x;
+			if (v.isZero()) return false;
+			t *= v;
+		}
+		b[i] = t;
+		// c[i] = b_0 ... b_i
+		c[i] = i == 0 ? t : c[i - 1] * t;
+	}
+	Fr inv;
+	Fr::inv(inv, c[m - 1]);
+	inv *= a;
+	// inv = a / (b_0 ... b_i)
+	for (size_t i = m - 1; i > 0; i--) {
+		c[i] = inv * c[i - 1];
+		inv *= b[i];
+	}
+	c[0] = inv;
+	return true;
+}
+
+// inner product for recoverSub of Fr
+inline void GmulVec(Fr& z, Fr *x, const Fr *y, mclSize n)
+{
+	z.clear();
+	for (size_t i = 0; i < n; i++) z += x[i] * y[i];
+}
+
+/*
+	*out = sum_i L_i vec[i] for i in [begin, end) such that mask[i] == 1 (all of them if mask is NULL)
+	by mulVec of each chunk
+	consecutive ; S is isConsecutive and mask is NULL
+	*pb = false if S has zero or the same values
+*/
+template<class G>
+void recoverSub(bool *pb, G *out, const G *vec, const Fr *S, const uint8_t *mask, size_t n, size_t begin, size_t end, bool consecutive)
+{
+	G x[lagrangeChunkN];
+	Fr c[lagrangeChunkN];
+	size_t idx[lagrangeChunkN];
+	out->clear();
+	LagrangeCoeffConsecutive lc;
+	if (consecutive && !lc.init(S[0], n, begin)) {
+		*pb = false;
+		return;
+	}
+	size_t pos = begin;
+	while (pos < end) {
+		size_t m = 0;
+		while (pos < end && m < lagrangeChunkN) {
+			if (mask == 0 || mask[pos] == 1) {
+				idx[m] = pos;
+				// mulVec may normalize x
+				x[m] = vec[pos];
+				m++;
+			}
+			pos++;
+		}
+		if (m == 0) break;
+		if (consecutive) {
+			lc.getVec(c, m);
+		} else if (!getLagrangeCoeffVec(c, S, mask, n, idx, m)) {
+			*pb = false;
+			return;
+		}
+		G t;
+		GmulVec(t, x, c, m);
+		*out += t;
+	}
+	*pb = true;
+}
+
+/*
+	out = f(0) for the polynomial f such that f(S[i]) = vec[i]
+	for i in [0, n) such that mask[i] == 1 (all of them if mask is NULL)
+	use the closed form of the coefficients if S is consecutive
+	split [0, n) into threadN blocks if threadN > 1
+	return false if S has zero or the same values
+*/
+template<class G>
+bool recoverMT(G& out, const G *vec, const Fr *S, const uint8_t *mask, size_t n, int threadN)
 {
+	if (n == 0) return false;
+	if (n == 1 && mask == 0) {
+		out = vec[0];
+		return true;
+	}
 	bool b;
-	LagrangeInterpolation(&b, *cast(&sec->v), cast(&idVec->v), cast(&secVec->v), n);
-	return b ? 0 : -1;
+	const bool consecutive = mask == 0 && isConsecutive(S, n);
+#ifdef BLS_MULTI_VERIFY_THREAD
+	const int maxThreadNum = 32;
+	if (threadN > maxThreadNum) threadN = maxThreadNum;
+	// the coefficients cost O(n) per element, so a small block is enough
+	const size_t minN = 32;
+	if (threadN > 1 && n >= minN * 2) {
+		if (size_t(threadN) > n / minN) threadN = int(n / minN);
+		G outVec[maxThreadNum];
+		bool bVec[maxThreadNum];
+		std::thread th[maxThreadNum];
+		size_t pos = 0;
+		for (int i = 0; i < threadN; i++) {
+			const size_t m = n * (i + 1) / threadN - pos;
+			th[i] = std::thread(recoverSub<G>, &bVec[i], &outVec[i], vec, S, mask, n, pos, pos + m, consecutive);
+			pos += m;
+		}
+		for (int i = 0; i < threadN; i++) {
+			th[i].join();
+		}
+		out = outVec[0];
+		b = bVec[0];
+		for (int i = 1; i < threadN; i++) {
+			out += outVec[i];
+			b = b && bVec[i];
+		}
+		return b;
+	}
+#else
+	(void)threadN;
+#endif
+	recoverSub(&b, &out, vec, S, mask, n, 0, n, consecutive);
+	return b;
+}
+
+int blsSecretKeyRecover(blsSecretKey *sec, const blsSecretKey *secVec, const blsId *idVec, mclSize n)
+{
+	return recoverMT(*cast(&sec->v), cast(&secVec->v), cast(&idVec->v), 0, n, 1) ? 0 : -1;
 }
 
 int blsPublicKeyRecover(blsPublicKey *pub, const blsPublicKey *pubVec, const blsId *idVec, mclSize n)
 {
-	bool b;
-	LagrangeInterpolation(&b, *cast(&pub->v), cast(&idVec->v), cast(&pubVec->v), n);
-	return b ? 0 : -1;
+	return recoverMT(*cast(&pub->v), cast(&pubVec->v), cast(&idVec->v), 0, n, 1) ? 0 : -1;
 }
 
 int blsSignatureRecover(blsSignature *sig, const blsSignature *sigVec, const blsId *idVec, mclSize n)
 {
-	bool b;
-	LagrangeInterpolation(&b, *cast(&sig->v), cast(&idVec->v), cast(&sigVec->v), n);
-	return b ? 0 : -1;
+	return recoverMT(*cast(&sig->v), cast(&sigVec->v), cast(&idVec->v), 0, n, 1) ? 0 : -1;
 }
 
 void blsSecretKeyAdd(blsSecretKey *sec, const blsSecretKey *rhs)
@@ -634,10 +1497,12 @@ void blsPublicKeyVerifyOrder(int doVerify)
 }
 int blsSignatureIsValidOrder(const blsSignature *sig)
 {
+	BLS_STAT_SCOPE(BLS_STAT_SUBGROUP_CHECK, 1);
 	return cast(&sig->v)->isValidOrder();
 }
 int blsPublicKeyIsValidOrder(const blsPublicKey *pub)
 {
+	BLS_STAT_SCOPE(BLS_STAT_SUBGROUP_CHECK, 1);
 	return cast(&pub->v)->isValidOrder();
 }
 
@@ -664,19 +1529,27 @@ inline bool toG(G& Hm, const void *h, mclSize size)
 int blsVerifyAggregatedHashes(const blsSignature *aggSig, const blsPublicKey *pubVec, const void *hVec, size_t sizeofHash, mclSize n)
 {
 	if (n == 0) return 0;
+	BLS_TRACE_SCOPE(BLS_PHASE_BATCH, n);
 	GT e;
 	const char *ph = (const char*)hVec;
 	const size_t N = 16;
 	G1 g1Vec[N+1]; // +1 is for the last appending element
 	G2 g2Vec[N+1];
 #ifdef BLS_ETH
+	const bool useExpand = g_irtfHashAndMap && useExpandMsg(g_ctx, n);
 	bool initE = true;
 	while (n > 0) {
 		size_t m = fp::min_<size_t>(n, N);
 		for (size_t i = 0; i < m; i++) {
 			g1Vec[i] = *cast(&pubVec[i].v);
 			if (g1Vec[i].isZero()) return 0;
-			if (!toG(g2Vec[i], &ph[i * sizeofHash], sizeofHash)) return 0;
+		}
+		if (g_irtfHashAndMap) {
+			hashAndMapToGVec(g_ctx, g2Vec, FixedSizeMsg(ph, sizeofHash), m, useExpand);
+		} else {
+			for (size_t i = 0; i < m; i++) {
+				if (!toG(g2Vec[i], &ph[i * sizeofHash], sizeofHash)) return 0;
+			}
 		}
 		pubVec += m;
 		ph += m * sizeofHash;
@@ -686,7 +1559,7 @@ int blsVerifyAggregatedHashes(const blsSignature *aggSig, const blsPublicKey *pu
 			G2::neg(g2Vec[m], *cast(&aggSig->v));
 			m++;
 		}
-		millerLoopVec(e, g1Vec, g2Vec, m, initE);
+		statMillerLoopVec(e, g1Vec, g2Vec, m, initE);
 		initE = false;
 	}
 #else
@@ -694,7 +1567,7 @@ int blsVerifyAggregatedHashes(const blsSignature *aggSig, const blsPublicKey *pu
 		e(aggSig, Q) = prod_i e(hVec[i], pubVec[i])
 		<=> finalExp(ML(-aggSig, Q) * prod_i ML(hVec[i], pubVec[i])) == 1
 	*/
-	precomputedMillerLoop(e, -*cast(&aggSig->v), g_Qcoeff.data());
+	statPrecomputedMillerLoop(e, -*cast(&aggSig->v), g_ctx.Qcoeff.data());
 	while (n > 0) {
 		size_t m = N;
 		if (n < m) m = n;
@@ -703,13 +1576,13 @@ int blsVerifyAggregatedHashes(const blsSignature *aggSig, const blsPublicKey *pu
 			g2Vec[i] = *cast(&pubVec[i].v);
 			if (g2Vec[i].isZero()) return 0;
 		}
-		millerLoopVec(e, g1Vec, g2Vec, m, false);
+		statMillerLoopVec(e, g1Vec, g2Vec, m, false);
 		pubVec += m;
 		ph += m * sizeofHash;
 		n -= m;
 	}
 #endif
-	finalExp(e, e);
+	statFinalExp(e, e);
 	return e.isOne();
 }
 
@@ -839,7 +1712,7 @@ mclSize blsSignatureDeserializeUncompressed(blsSignature *sig, const void *buf,
 int blsVerifyPairing(const blsSignature *X, const blsSignature *Y, const blsPublicKey *pub)
 {
 #ifdef BLS_ETH
-	return isEqualTwoPairings(*cast(&X->v), *cast(&pub->v), *cast(&Y->v));
+	return isEqualTwoPairings(getBasePoint(), *cast(&X->v), *cast(&pub->v), *cast(&Y->v));
 #else
 	return isEqualTwoPairings(*cast(&X->v), getQcoeff().data(), *cast(&Y->v), *cast(&pub->v));
 #endif
@@ -908,70 +1781,249 @@ void blsSignatureMulVec(blsSignature *z, blsSignature *x, const blsSecretKey *y,
 	GmulVec(*cast(&z->v), cast(&x->v), cast(&y->v), n);
 }
 
-mclSize blsGetOpUnitSize() // FpUint64Size
+#ifdef BLS_MULTI_VERIFY_THREAD
+template<class G>
+void GmulVecThread(G *z, G *x, const Fr *y, size_t n)
 {
-	return Fp::getUnitSize() * sizeof(Unit) / sizeof(uint64_t);
+	GmulVec(*z, x, y, n);
 }
+#endif
 
-int blsGetCurveOrder(char *buf, mclSize maxBufSize)
+/*
+	split x and y into threadN blocks and add mulVec of each block
+*/
+template<class G>
+void GmulVecMT(G& z, G *x, const Fr *y, size_t n, int threadN)
 {
-	return (int)Fr::getModulo(buf, maxBufSize);
+#ifdef BLS_MULTI_VERIFY_THREAD
+	const int maxThreadNum = 32;
+	if (threadN > maxThreadNum) threadN = maxThreadNum;
+	// mulVec of a small block is slow per element
+	const size_t minN = 256;
+	if (threadN > 1 && n >= minN * 2) {
+		if (size_t(threadN) > n / minN) threadN = int(n / minN);
+		G zt[maxThreadNum];
+		std::thread th[maxThreadNum];
+		size_t pos = 0;
+		for (int i = 0; i < threadN; i++) {
+			const size_t m = n * (i + 1) / threadN - pos;
+			th[i] = std::thread(GmulVecThread<G>, &zt[i], x + pos, y + pos, m);
+			pos += m;
+		}
+		for (int i = 0; i < threadN; i++) {
+			th[i].join();
+		}
+		z = zt[0];
+		for (int i = 1; i < threadN; i++) {
+			z += zt[i];
+		}
+		return;
+	}
+#else
+	(void)threadN;
+#endif
+	GmulVec(z, x, y, n);
 }
 
-int blsGetFieldOrder(char *buf, mclSize maxBufSize)
+void blsPublicKeyMulVecMT(blsPublicKey *z, blsPublicKey *x, const blsSecretKey *y, mclSize n, int threadN)
 {
-	return (int)Fp::getModulo(buf, maxBufSize);
+	GmulVecMT(*cast(&z->v), cast(&x->v), cast(&y->v), n, threadN);
 }
 
-int blsGetSerializedSecretKeyByteSize()
+void blsSignatureMulVecMT(blsSignature *z, blsSignature *x, const blsSecretKey *y, mclSize n, int threadN)
 {
-	return blsGetFrByteSize();
+	GmulVecMT(*cast(&z->v), cast(&x->v), cast(&y->v), n, threadN);
 }
 
-int blsGetSerializedPublicKeyByteSize()
+int blsPublicKeyRecoverMT(blsPublicKey *pub, const blsPublicKey *pubVec, const blsId *idVec, mclSize n, int threadN)
 {
-#ifdef BLS_ETH
-	return blsGetG1ByteSize();
-#else
-	return blsGetG1ByteSize() * 2;
-#endif
+	return recoverMT(*cast(&pub->v), cast(&pubVec->v), cast(&idVec->v), 0, n, threadN) ? 0 : -1;
 }
 
-int blsGetSerializedSignatureByteSize()
+int blsSignatureRecoverMT(blsSignature *sig, const blsSignature *sigVec, const blsId *idVec, mclSize n, int threadN)
 {
-#ifdef BLS_ETH
-	return blsGetG1ByteSize() * 2;
-#else
-	return blsGetG1ByteSize();
-#endif
+	return recoverMT(*cast(&sig->v), cast(&sigVec->v), cast(&idVec->v), 0, n, threadN) ? 0 : -1;
 }
 
-int blsGetG1ByteSize()
+// sigVec[i] = secVec[i] Hm and normalize them
+void signManyKeysSub(G *sigVec, const Fr *secVec, const G *Hm, size_t n)
 {
-	return (int)Fp::getByteSize();
+	const size_t N = 16;
+	G t[N];
+	size_t pos = 0;
+	while (pos < n) {
+		const size_t m = fp::min_<size_t>(n - pos, N);
+		for (size_t i = 0; i < m; i++) {
+			GmulCT(t[i], *Hm, secVec[pos + i]);
+		}
+		G::normalizeVec(sigVec + pos, t, m);
+		pos += m;
+	}
 }
 
-int blsGetFrByteSize()
+void blsSignManyKeys(blsSignature *sigVec, const blsSecretKey *secVec, mclSize n, const void *msg, mclSize msgSize, int threadN)
 {
-	return (int)Fr::getByteSize();
+	G Hm;
+	hashAndMapToG(Hm, msg, msgSize);
+	G *out = cast(&sigVec[0].v);
+	const Fr *sec = cast(&secVec[0].v);
+#ifdef BLS_MULTI_VERIFY_THREAD
+	const int maxThreadNum = 32;
+	if (threadN > maxThreadNum) threadN = maxThreadNum;
+	const size_t minN = 16;
+	if (threadN > 1 && n >= minN * 2) {
+		if (size_t(threadN) > n / minN) threadN = int(n / minN);
+		std::thread th[maxThreadNum];
+		size_t pos = 0;
+		for (int i = 0; i < threadN; i++) {
+			const size_t m = n * (i + 1) / threadN - pos;
+			th[i] = std::thread(signManyKeysSub, out + pos, sec + pos, &Hm, m);
+			pos += m;
+		}
+		for (int i = 0; i < threadN; i++) {
+			th[i].join();
+		}
+		return;
+	}
+#else
+	(void)threadN;
+#endif
+	signManyKeysSub(out, sec, &Hm, n);
 }
 
-void blsGetGeneratorOfPublicKey(blsPublicKey *pub)
+// sigVec[i] = sec H(msgs[i]) and normalize them
+template<class Msgs>
+void signVecSub(G *sigVec, const Fr *sec, Msgs msgs, size_t n, bool useExpand)
 {
-	*cast(&pub->v) = getBasePoint();
-}
-
-int blsSetGeneratorOfPublicKey(const blsPublicKey *pub)
+	const size_t N = 16;
+	G t[N];
+	size_t pos = 0;
+	while (pos < n) {
+		const size_t m = fp::min_<size_t>(n - pos, N);
+		hashAndMapToGVec(g_ctx, t, msgs.skip(pos), m, useExpand);
+		for (size_t i = 0; i < m; i++) {
+			GmulCT(t[i], t[i], *sec);
+		}
+		G::normalizeVec(sigVec + pos, t, m);
+		pos += m;
+	}
+}
+
+void blsSignVec(blsSignature *sigVec, const blsSecretKey *sec, const void *msgVec, const mclSize *msgOffsetVec, mclSize n, int threadN)
+{
+	G *out = cast(&sigVec[0].v);
+	const Fr *s = cast(&sec->v);
+	const VarSizeMsg msgs(msgVec, msgOffsetVec);
+	// decide once for all the threads
+	const bool useExpand = useExpandMsg(g_ctx, n);
+#ifdef BLS_MULTI_VERIFY_THREAD
+	const int maxThreadNum = 32;
+	if (threadN > maxThreadNum) threadN = maxThreadNum;
+	const size_t minN = 16;
+	if (threadN > 1 && n >= minN * 2) {
+		if (size_t(threadN) > n / minN) threadN = int(n / minN);
+		std::thread th[maxThreadNum];
+		size_t pos = 0;
+		for (int i = 0; i < threadN; i++) {
+			const size_t m = n * (i + 1) / threadN - pos;
+			th[i] = std::thread(signVecSub<VarSizeMsg>, out + pos, s, msgs.skip(pos), m, useExpand);
+			pos += m;
+		}
+		for (int i = 0; i < threadN; i++) {
+			th[i].join();
+		}
+		return;
+	}
+#else
+	(void)threadN;
+#endif
+	signVecSub(out, s, msgs, n, useExpand);
+}
+
+mclSize blsGetOpUnitSize() // FpUint64Size
+{
+	return Fp::getUnitSize() * sizeof(Unit) / sizeof(uint64_t);
+}
+
+int blsGetCurveOrder(char *buf, mclSize maxBufSize)
+{
+	return (int)Fr::getModulo(buf, maxBufSize);
+}
+
+int blsGetFieldOrder(char *buf, mclSize maxBufSize)
+{
+	return (int)Fp::getModulo(buf, maxBufSize);
+}
+
+int blsGetSerializedSecretKeyByteSize()
+{
+	return blsGetFrByteSize();
+}
+
+int blsGetSerializedPublicKeyByteSize()
 {
 #ifdef BLS_ETH
-	g_P = *cast(&pub->v);
-	return 0;
+	return blsGetG1ByteSize();
+#else
+	return blsGetG1ByteSize() * 2;
+#endif
+}
+
+int blsGetSerializedSignatureByteSize()
+{
+#ifdef BLS_ETH
+	return blsGetG1ByteSize() * 2;
+#else
+	return blsGetG1ByteSize();
+#endif
+}
+
+int blsGetG1ByteSize()
+{
+	return (int)Fp::getByteSize();
+}
+
+int blsGetFrByteSize()
+{
+	return (int)Fr::getByteSize();
+}
+
+void blsGetGeneratorOfPublicKey(blsPublicKey *pub)
+{
+	*cast(&pub->v) = getBasePoint();
+}
+
+int blsSetGeneratorOfPublicKey(const blsPublicKey *pub)
+{
+#ifdef BLS_ETH
+	g_ctx.gen = *cast(&pub->v);
 #else
-	g_Q = *cast(&pub->v);
+	g_ctx.gen = *cast(&pub->v);
 	bool b;
-	precomputeG2(&b, g_Qcoeff, getBasePoint());
-	return b ? 0 : -1;
+	precomputeG2(&b, g_ctx.Qcoeff, getBasePoint());
+	if (!b) return -1;
 #endif
+	return updateGenTbl() ? 0 : -1;
+}
+
+int blsSetGeneratorTableWindow(int w)
+{
+	if (w == 0) {
+		g_genTbl.clear();
+		return 0;
+	}
+	if (w < 2 || size_t(w) > g_genTbl.getMaxWindow()) return -1;
+	return initGenTbl(size_t(w)) ? 0 : -1;
+}
+
+int blsGetGeneratorTableWindow()
+{
+	return int(g_genTbl.getWindow());
+}
+
+int blsGetMaxGeneratorTableWindow()
+{
+	return int(g_genTbl.getMaxWindow());
 }
 
 int blsIdSetDecStr(blsId *id, const char *buf, mclSize bufSize)
@@ -1036,6 +2088,97 @@ int blsVerifyPop(const blsSignature *sig, const blsPublicKey *pub)
 	return blsVerify(sig, pub, buf, n);
 }
 
+/*
+	check all PoPs in [0, n) by one random linear combination
+	ETH     ; prod_i e(r_i pub_i, H(pub_i)) == e(P, sum_i r_i pop_i)
+	non-ETH ; prod_i e(H(pub_i), r_i pub_i) == e(sum_i r_i pop_i, Q)
+	return false if some pubVec[i] is zero
+*/
+bool verifyPopCombined(const blsSignature *popVec, const blsPublicKey *pubVec, const char *randVec, mclSize randSize, mclSize n)
+{
+	const bool useExpand = useExpandMsg(g_ctx, n);
+	const size_t N = 16;
+	const size_t maxSerializedSize = sizeof(Gother);
+	char buf[N * maxSerializedSize];
+	mclSize offsetVec[N + 1];
+	Fr rand[N];
+	G hVec[N];
+	G popVec2[N];
+	Gother pubVec2[N];
+	G aggPop;
+	GT e;
+	bool initE = true;
+	aggPop.clear();
+	while (n > 0) {
+		const size_t m = fp::min_<size_t>(n, N);
+		offsetVec[0] = 0;
+		{
+			BLS_TRACE_SCOPE(BLS_PHASE_MUL, m);
+			for (size_t i = 0; i < m; i++) {
+				const Gother& pub = *cast(&pubVec[i].v);
+				if (pub.isZero()) return false;
+				const size_t size = pub.serialize(buf + offsetVec[i], maxSerializedSize);
+				if (size == 0) return false;
+				offsetVec[i + 1] = offsetVec[i] + size;
+				bool b;
+				rand[i].setArray(&b, (const uint8_t *)&randVec[i * randSize], randSize);
+				(void)b;
+				Gmul(pubVec2[i], pub, rand[i]);
+				popVec2[i] = *cast(&popVec[i].v);
+			}
+		}
+		hashAndMapToGVec(g_ctx, hVec, VarSizeMsg(buf, offsetVec), m, useExpand);
+		G t;
+		GmulVec(t, popVec2, rand, m);
+		aggPop += t;
+#ifdef BLS_ETH
+		statMillerLoopVec(e, pubVec2, hVec, m, initE);
+#else
+		statMillerLoopVec(e, hVec, pubVec2, m, initE);
+#endif
+		initE = false;
+		popVec += m;
+		pubVec += m;
+		randVec += m * randSize;
+		n -= m;
+	}
+	GT t;
+#ifdef BLS_ETH
+	statMillerLoop(t, -getBasePoint(), aggPop);
+#else
+	statPrecomputedMillerLoop(t, -aggPop, g_ctx.Qcoeff.data());
+#endif
+	e *= t;
+	statFinalExp(e, e);
+	return e.isOne();
+}
+
+/*
+	set okVec[i] for i in [0, n) by bisection of the failed combinations
+	return the number of valid PoPs
+*/
+mclSize verifyPopVecSub(uint8_t *okVec, const blsSignature *popVec, const blsPublicKey *pubVec, const char *randVec, mclSize randSize, mclSize n)
+{
+	if (verifyPopCombined(popVec, pubVec, randVec, randSize, n)) {
+		memset(okVec, 1, n);
+		return n;
+	}
+	if (n == 1) {
+		okVec[0] = 0;
+		return 0;
+	}
+	const mclSize h = n / 2;
+	return verifyPopVecSub(okVec, popVec, pubVec, randVec, randSize, h)
+		+ verifyPopVecSub(okVec + h, popVec + h, pubVec + h, randVec + h * randSize, randSize, n - h);
+}
+
+mclSize blsVerifyPopVec(uint8_t *okVec, const blsSignature *popVec, const blsPublicKey *pubVec, mclSize n, const void *randVec, mclSize randSize)
+{
+	if (n == 0) return 0;
+	BLS_TRACE_SCOPE(BLS_PHASE_BATCH, n);
+	return verifyPopVecSub(okVec, popVec, pubVec, (const char*)randVec, randSize, n);
+}
+
 mclSize blsIdGetLittleEndian(void *buf, mclSize maxBufSize, const blsId *id)
 {
 	return cast(&id->v)->serialize(buf, maxBufSize);
@@ -1088,10 +2231,8 @@ void normalizePubVec(blsPublicKey *pubVec, mclSize n)
 	}
 }
 
-#define CYBOZU_DONT_USE_OPENSSL
-#include <cybozu/sha2.hpp>
 #include <cybozu/endian.hpp>
-void hashPublicKey(cybozu::Sha256& h, const blsPublicKey *pubVec, mclSize n)
+void hashPublicKey(bls_sha256::Sha256& h, const blsPublicKey *pubVec, mclSize n)
 {
 	for (size_t i = 0; i < n; i++) {
 		const Gother& v = *cast(&pubVec[i].v);
@@ -1105,20 +2246,32 @@ void hashPublicKey(cybozu::Sha256& h, const blsPublicKey *pubVec, mclSize n)
 	}
 }
 
-void hashToFr(Fr *out, const cybozu::Sha256& h0, mclSize begin, mclSize n)
+/*
+	out[i] = SHA-256(prefix || LE32(begin + i)) for i = 0, ..., n-1 where prefix is the data given to h0
+	the digests of N indices are computed at once by the multi-buffer kernel
+*/
+void hashToFr(Fr *out, const bls_sha256::Sha256& h0, mclSize begin, mclSize n)
 {
-	for (size_t i = 0; i < n; i++) {
-		cybozu::Sha256 h = h0;
-		uint8_t md[32];
-		char buf[4];
-		cybozu::Set32bitAsLE(buf, uint32_t(begin + i));
-		h.digest(md, sizeof(md), buf, sizeof(buf));
-		out[i].setArrayMask(md, sizeof(md));
+	const size_t N = 16;
+	uint8_t md[32 * N];
+	char buf[4 * N];
+	size_t pos = 0;
+	while (pos < n) {
+		size_t m = n - pos;
+		if (m > N) m = N;
+		for (size_t i = 0; i < m; i++) {
+			cybozu::Set32bitAsLE(buf + 4 * i, uint32_t(begin + pos + i));
+		}
+		bls_sha256::digestVec(md, h0, buf, 4, m);
+		for (size_t i = 0; i < m; i++) {
+			out[pos + i].setArrayMask(md + 32 * i, 32);
+		}
+		pos += m;
 	}
 }
 
 template<class T, class U>
-void aggregate(T& out, const cybozu::Sha256& h0, U *vec, mclSize n)
+void aggregate(T& out, const bls_sha256::Sha256& h0, U *vec, mclSize n)
 {
 	out.clear();
 	const size_t N = 16;
@@ -1139,7 +2292,7 @@ void aggregate(T& out, const cybozu::Sha256& h0, U *vec, mclSize n)
 void blsMultiAggregateSignature(blsSignature *aggSig, blsSignature *sigVec, blsPublicKey *pubVec, mclSize n)
 {
 	normalizePubVec(pubVec, n);
-	cybozu::Sha256 h0;
+	bls_sha256::Sha256 h0;
 	hashPublicKey(h0, pubVec, n);
 	G out;
 	aggregate(out, h0, sigVec, n);
@@ -1149,12 +2302,654 @@ void blsMultiAggregateSignature(blsSignature *aggSig, blsSignature *sigVec, blsP
 void blsMultiAggregatePublicKey(blsPublicKey *aggPub, blsPublicKey *pubVec, mclSize n)
 {
 	normalizePubVec(pubVec, n);
-	cybozu::Sha256 h0;
+	bls_sha256::Sha256 h0;
 	hashPublicKey(h0, pubVec, n);
 	Gother out;
 	aggregate(out, h0, pubVec, n);
 	*cast(&aggPub->v) = out;
 }
 
+void blsMultiAggregateContextInit(blsMultiAggregateContext *ctx, blsSecretKey *coeffVec, blsPublicKey *pubVec, mclSize n)
+{
+	ctx->coeffVec = coeffVec;
+	ctx->n = n;
+	if (n == 0) {
+		cast(&ctx->aggPub.v)->clear();
+		return;
+	}
+	normalizePubVec(pubVec, n);
+	bls_sha256::Sha256 h0;
+	hashPublicKey(h0, pubVec, n);
+	Fr *t = cast(&coeffVec[0].v);
+	hashToFr(t, h0, 0, n);
+	GmulVec(*cast(&ctx->aggPub.v), cast(&pubVec[0].v), t, n);
+}
+
+void blsMultiAggregateSignatureWithContext(blsSignature *aggSig, blsSignature *sigVec, const blsMultiAggregateContext *ctx)
+{
+	if (ctx->n == 0) {
+		cast(&aggSig->v)->clear();
+		return;
+	}
+	GmulVec(*cast(&aggSig->v), cast(&sigVec[0].v), cast(&ctx->coeffVec[0].v), ctx->n);
+}
+
+/*
+	secVec[i] = (H(seed || LE64(begin + i) || 0) || H(seed || LE64(begin + i) || 1)) mod r
+	pubVec[i] = secVec[i] P by g_genTbl if it is enabled
+	where H(seed || ...) is SHA-256 with the midstate h0 of seed
+*/
+void keyGenVecSub(Fr *secVec, Gother *pubVec, const bls_sha256::Sha256 *h0, uint64_t begin, size_t n)
+{
+	const size_t N = 8;
+	const size_t sufSize = 9;
+	char suf[N * 2 * sufSize];
+	uint8_t md[N * 2 * 32];
+	Gother t[N];
+	const bool useTbl = g_genTbl.isInitialized();
+	size_t pos = 0;
+	while (pos < n) {
+		const size_t m = fp::min_<size_t>(n - pos, N);
+		for (size_t i = 0; i < m * 2; i++) {
+			cybozu::Set64bitAsLE(suf + sufSize * i, begin + pos + i / 2);
+			suf[sufSize * i + 8] = char(i % 2);
+		}
+		bls_sha256::digestVec(md, *h0, suf, sufSize, m * 2);
+		for (size_t i = 0; i < m; i++) {
+			bool b;
+			secVec[pos + i].setArrayMod(&b, md + 64 * i, 64);
+			(void)b;
+			if (useTbl) {
+				g_genTbl.mul(t[i], secVec[pos + i]);
+			} else {
+				Gmul(t[i], getBasePoint(), secVec[pos + i]);
+			}
+		}
+		Gother::normalizeVec(pubVec + pos, t, m);
+		pos += m;
+	}
+}
+
+void blsKeyGenVec(blsSecretKey *secVec, blsPublicKey *pubVec, mclSize n, const void *seed, mclSize seedSize, mclSize begin, int threadN)
+{
+	bls_sha256::Sha256 h0;
+	h0.update(seed, seedSize);
+	Fr *sec = cast(&secVec[0].v);
+	Gother *pub = cast(&pubVec[0].v);
+#ifdef BLS_MULTI_VERIFY_THREAD
+	const int maxThreadNum = 32;
+	if (threadN > maxThreadNum) threadN = maxThreadNum;
+	const size_t minN = 16;
+	if (threadN > 1 && n >= minN * 2) {
+		if (size_t(threadN) > n / minN) threadN = int(n / minN);
+		std::thread th[maxThreadNum];
+		size_t pos = 0;
+		for (int i = 0; i < threadN; i++) {
+			const size_t m = n * (i + 1) / threadN - pos;
+			th[i] = std::thread(keyGenVecSub, sec + pos, pub + pos, &h0, uint64_t(begin + pos), m);
+			pos += m;
+		}
+		for (int i = 0; i < threadN; i++) {
+			th[i].join();
+		}
+		return;
+	}
+#else
+	(void)threadN;
+#endif
+	keyGenVecSub(sec, pub, &h0, begin, n);
+}
+
+static inline Context *cast(blsContext *ctx) { return (Context*)ctx; }
+static inline const Context *cast(const blsContext *ctx) { return (const Context*)ctx; }
+
+// blsGetContextByteSize in bls.h says that ctx is aligned to 8 bytes
+#ifdef _MSC_VER
+typedef char ContextAlignmentIsAtMost8[__alignof(Context) <= 8 ? 1 : -1];
+#else
+typedef char ContextAlignmentIsAtMost8[__alignof__(Context) <= 8 ? 1 : -1];
+#endif
+
+mclSize blsGetContextByteSize()
+{
+	return sizeof(Context);
+}
+
+void blsContextInit(blsContext *ctx)
+{
+	new (cast(ctx)) Context(g_ctx);
+}
+
+int blsContextSetGeneratorOfPublicKey(blsContext *ctx, const blsPublicKey *pub)
+{
+	Context& c = *cast(ctx);
+	c.gen = *cast(&pub->v);
+#ifndef BLS_ETH
+	bool b;
+	precomputeG2(&b, c.Qcoeff, c.gen);
+	if (!b) return -1;
+#endif
+	return 0;
+}
+
+void blsContextGetGeneratorOfPublicKey(blsPublicKey *pub, const blsContext *ctx)
+{
+	*cast(&pub->v) = cast(ctx)->gen;
+}
+
+int blsContextSetDst(blsContext *ctx, const char *dst, mclSize dstSize)
+{
+#ifdef BLS_ETH
+	Context& c = *cast(ctx);
+	if (g_curveType != MCL_BLS12_381 || getMapToMode() != MCL_MAP_TO_MODE_HASH_TO_CURVE_07) return -1;
+	if (dstSize > bls_sha256::ExpandMsgXmd::maxDstSize) return -1;
+	c.expandMsg.setDst(dst, dstSize);
+	c.hasDst = true;
+	c.followMcl = false;
+	return 0;
+#else
+	(void)ctx;
+	(void)dst;
+	(void)dstSize;
+	return -1;
+#endif
+}
+
+void blsGetPublicKeyWithContext(blsPublicKey *pub, const blsSecretKey *sec, const blsContext *ctx)
+{
+	Gmul(*cast(&pub->v), cast(ctx)->gen, *cast(&sec->v));
+}
+
+void blsSignWithContext(blsSignature *sig, const blsSecretKey *sec, const void *m, mclSize size, const blsContext *ctx)
+{
+	hashAndMapToG(*cast(ctx), *cast(&sig->v), m, size);
+	blsSignHashedPoint(sig, sec, sig);
+}
+
+int blsVerifyWithContext(const blsSignature *sig, const blsPublicKey *pub, const void *m, mclSize size, const blsContext *ctx)
+{
+	return verify(*cast(ctx), sig, pub, m, size);
+}
+
+int blsFastAggregateVerifyWithContext(const blsSignature *sig, const blsPublicKey *pubVec, mclSize n, const void *msg, mclSize msgSize, const blsContext *ctx)
+{
+	return fastAggregateVerify(*cast(ctx), sig, pubVec, n, msg, msgSize);
+}
+
+int blsAggregateVerifyWithContext(const blsSignature *sig, const blsPublicKey *pubVec, const void *msgVec, mclSize msgSize, mclSize n, const blsContext *ctx)
+{
+#ifdef BLS_ETH
+	return aggregateVerify(*cast(ctx), sig, pubVec, FixedSizeMsg(msgVec, msgSize), n);
+#else
+	(void)sig;
+	(void)pubVec;
+	(void)msgVec;
+	(void)msgSize;
+	(void)n;
+	(void)ctx;
+	return 0;
+#endif
+}
+
+int blsAggregateVerifyNoCheckWithContext(const blsSignature *sig, const blsPublicKey *pubVec, const void *msgVec, mclSize msgSize, mclSize n, const blsContext *ctx)
+{
+#ifdef BLS_ETH
+	return aggregateVerifyNoCheck(*cast(ctx), sig, pubVec, FixedSizeMsg(msgVec, msgSize), n);
+#else
+	(void)sig;
+	(void)pubVec;
+	(void)msgVec;
+	(void)msgSize;
+	(void)n;
+	(void)ctx;
+	return 0;
+#endif
+}
+
+/*
+	out = sum_i r_i (sum_j id^j mpkVec[k i + j] - secVec[i] P) for i in [0, n)
+	which is zero if all shares are valid
+*/
+void shareCombinedSub(Gother *out, const Fr *secVec, const Gother *mpkVec, size_t k, const Fr *id, const char *randVec, size_t randSize, size_t n)
+{
+	BLS_TRACE_SCOPE(BLS_PHASE_WORKER, n);
+	const size_t N = 64;
+	Gother xVec[N];
+	Fr yVec[N];
+	Gother T;
+	Fr s;
+	size_t m = 0;
+	out->clear();
+	s.clear();
+	for (size_t i = 0; i < n; i++) {
+		Fr r;
+		bool b;
+		r.setArray(&b, (const uint8_t *)&randVec[i * randSize], randSize);
+		(void)b;
+		s += r * secVec[i];
+		for (size_t j = 0; j < k; j++) {
+			xVec[m] = mpkVec[k * i + j];
+			yVec[m] = r;
+			r *= *id;
+			m++;
+			if (m == N) {
+				GmulVec(T, xVec, yVec, m);
+				*out += T;
+				m = 0;
+			}
+		}
+	}
+	xVec[m] = getBasePoint();
+	Fr::neg(yVec[m], s);
+	m++;
+	GmulVec(T, xVec, yVec, m);
+	*out += T;
+}
+
+// check the shares in [0, n) by one random linear combination
+bool verifyShareCombined(const Fr *secVec, const Gother *mpkVec, size_t k, const Fr *id, const char *randVec, size_t randSize, size_t n, int threadN)
+{
+	Gother T;
+#ifdef BLS_MULTI_VERIFY_THREAD
+	const int maxThreadNum = 32;
+	if (threadN > maxThreadNum) threadN = maxThreadNum;
+	const size_t minN = 4;
+	if (threadN > 1 && n >= minN * 2) {
+		if (size_t(threadN) > n / minN) threadN = int(n / minN);
+		std::thread th[maxThreadNum];
+		Gother outVec[maxThreadNum];
+		size_t pos = 0;
+		for (int i = 0; i < threadN; i++) {
+			const size_t m = n * (i + 1) / threadN - pos;
+			th[i] = std::thread(shareCombinedSub, &outVec[i], secVec + pos, mpkVec + k * pos, k, id, randVec + randSize * pos, randSize, m);
+			pos += m;
+		}
+		T.clear();
+		BLS_TRACE_SCOPE(BLS_PHASE_JOIN, threadN);
+		for (int i = 0; i < threadN; i++) {
+			th[i].join();
+			T += outVec[i];
+		}
+		return T.isZero();
+	}
+#else
+	(void)threadN;
+#endif
+	shareCombinedSub(&T, secVec, mpkVec, k, id, randVec, randSize, n);
+	return T.isZero();
+}
+
+/*
+	set okVec[i] for i in [0, n) by bisection of the failed combinations
+	return the number of valid shares
+*/
+mclSize verifyShareVecSub(uint8_t *okVec, const Fr *secVec, const Gother *mpkVec, size_t k, const Fr *id, const char *randVec, size_t randSize, size_t n, int threadN)
+{
+	if (verifyShareCombined(secVec, mpkVec, k, id, randVec, randSize, n, threadN)) {
+		memset(okVec, 1, n);
+		return n;
+	}
+	if (n == 1) {
+		okVec[0] = 0;
+		return 0;
+	}
+	const size_t h = n / 2;
+	return verifyShareVecSub(okVec, secVec, mpkVec, k, id, randVec, randSize, h, threadN)
+		+ verifyShareVecSub(okVec + h, secVec + h, mpkVec + k * h, k, id, randVec + randSize * h, randSize, n - h, threadN);
+}
+
+mclSize blsVerifySecretKeyShareVec(uint8_t *okVec, const blsSecretKey *secVec, const blsPublicKey *mpkVec, mclSize k, const blsId *id, mclSize n, const void *randVec, mclSize randSize, int threadN)
+{
+	if (n == 0) return 0;
+	if (k == 0) {
+		memset(okVec, 0, n);
+		return 0;
+	}
+	BLS_TRACE_SCOPE(BLS_PHASE_BATCH, n);
+	return verifyShareVecSub(okVec, cast(&secVec[0].v), cast(&mpkVec[0].v), k, cast(&id->v), (const char*)randVec, randSize, n, threadN);
+}
+
+// secVec[i] = sum_j msk[j] idVec[i]^j by Horner's method
+void secretKeyShareVecSub(Fr *secVec, const Fr *msk, size_t k, const Fr *idVec, size_t n)
+{
+	for (size_t i = 0; i < n; i++) {
+		Fr y = msk[k - 1];
+		for (size_t j = k - 1; j > 0; j--) {
+			y *= idVec[i];
+			y += msk[j - 1];
+		}
+		secVec[i] = y;
+	}
+}
+
+/*
+	pubVec[i] = sum_j mpk[j] idVec[i]^j
+	by multi-scalar multiplications of chunks of mpk and the powers of idVec[i]
+	instead of k scalar multiplications of Horner's method
+*/
+void publicKeyShareVecSub(Gother *pubVec, const Gother *mpk, size_t k, const Fr *idVec, size_t n)
+{
+	const size_t N = 64;
+	Gother xVec[N];
+	Fr yVec[N];
+	for (size_t i = 0; i < n; i++) {
+		Fr t = 1;
+		Gother pub;
+		pub.clear();
+		size_t pos = 0;
+		while (pos < k) {
+			const size_t m = fp::min_<size_t>(k - pos, N);
+			for (size_t j = 0; j < m; j++) {
+				xVec[j] = mpk[pos + j];
+				yVec[j] = t;
+				t *= idVec[i];
+			}
+			Gother T;
+			GmulVec(T, xVec, yVec, m);
+			pub += T;
+			pos += m;
+		}
+		pubVec[i] = pub;
+	}
+}
+
+// split the ids into threadN threads
+template<class T>
+void shareVecMT(void (*f)(T*, const T*, size_t, const Fr*, size_t), T *outVec, const T *c, size_t k, const Fr *idVec, size_t n, int threadN)
+{
+#ifdef BLS_MULTI_VERIFY_THREAD
+	const int maxThreadNum = 32;
+	if (threadN > maxThreadNum) threadN = maxThreadNum;
+	const size_t minN = 16;
+	if (threadN > 1 && n >= minN * 2) {
+		if (size_t(threadN) > n / minN) threadN = int(n / minN);
+		std::thread th[maxThreadNum];
+		size_t pos = 0;
+		for (int i = 0; i < threadN; i++) {
+			const size_t m = n * (i + 1) / threadN - pos;
+			th[i] = std::thread(f, outVec + pos, c, k, idVec + pos, m);
+			pos += m;
+		}
+		for (int i = 0; i < threadN; i++) {
+			th[i].join();
+		}
+		return;
+	}
+#else
+	(void)threadN;
+#endif
+	f(outVec, c, k, idVec, n);
+}
+
+int blsSecretKeyShareVec(blsSecretKey *secVec, const blsSecretKey *msk, mclSize k, const blsId *idVec, mclSize n, int threadN)
+{
+	if (k == 0) return -1;
+	if (n == 0) return 0;
+	shareVecMT(secretKeyShareVecSub, cast(&secVec[0].v), cast(&msk[0].v), k, cast(&idVec[0].v), n, threadN);
+	return 0;
+}
+
+int blsPublicKeyShareVec(blsPublicKey *pubVec, const blsPublicKey *mpk, mclSize k, const blsId *idVec, mclSize n, int threadN)
+{
+	if (k == 0) return -1;
+	if (n == 0) return 0;
+	shareVecMT(publicKeyShareVecSub, cast(&pubVec[0].v), cast(&mpk[0].v), k, cast(&idVec[0].v), n, threadN);
+	return 0;
+}
+
+/*
+	coeffVec[i] = prod_{j != i} idVec[j] / (idVec[j] - idVec[i]) = a / b_i
+	where a = prod_j idVec[j], b_i = idVec[i] prod_{j != i} (idVec[j] - idVec[i])
+	the same coefficients as blsSecretKeyRecover by getLagrangeCoeffVec
+*/
+int blsGetLagrangeCoefficient(blsSecretKey *coeffVec, const blsId *idVec, mclSize n)
+{
+	if (n == 0) return -1;
+	const Fr *S = cast(&idVec[0].v);
+	Fr *c = cast(&coeffVec[0].v);
+	if (isConsecutive(S, n)) {
+		LagrangeCoeffConsecutive lc;
+		if (!lc.init(S[0], n, 0)) return -1;
+		for (size_t pos = 0; pos < n; pos += lagrangeChunkN) {
+			lc.getVec(c + pos, fp::min_<size_t>(n - pos, lagrangeChunkN));
+		}
+		return 0;
+	}
+	size_t idx[lagrangeChunkN];
+	for (size_t pos = 0; pos < n; pos += lagrangeChunkN) {
+		const size_t m = fp::min_<size_t>(n - pos, lagrangeChunkN);
+		for (size_t i = 0; i < m; i++) idx[i] = pos + i;
+		if (!getLagrangeCoeffVec(c + pos, S, 0, n, idx, m)) return -1;
+	}
+	return 0;
+}
+
+int blsRecoveryPlanInit(blsRecoveryPlan *plan, blsSecretKey *coeffVec, const blsId *idVec, mclSize n)
+{
+	plan->coeffVec = coeffVec;
+	plan->n = 0;
+	if (blsGetLagrangeCoefficient(coeffVec, idVec, n) != 0) return -1;
+	plan->n = n;
+	return 0;
+}
+
+int blsSecretKeyRecoverWithPlan(blsSecretKey *sec, const blsSecretKey *secVec, const blsRecoveryPlan *plan)
+{
+	if (plan->n == 0) return -1;
+	const Fr *c = cast(&plan->coeffVec[0].v);
+	Fr s;
+	s.clear();
+	for (size_t i = 0; i < plan->n; i++) {
+		s += c[i] * *cast(&secVec[i].v);
+	}
+	*cast(&sec->v) = s;
+	return 0;
+}
+
+int blsPublicKeyRecoverWithPlan(blsPublicKey *pub, blsPublicKey *pubVec, const blsRecoveryPlan *plan)
+{
+	if (plan->n == 0) return -1;
+	GmulVec(*cast(&pub->v), cast(&pubVec[0].v), cast(&plan->coeffVec[0].v), plan->n);
+	return 0;
+}
+
+int blsSignatureRecoverWithPlan(blsSignature *sig, blsSignature *sigVec, const blsRecoveryPlan *plan)
+{
+	if (plan->n == 0) return -1;
+	GmulVec(*cast(&sig->v), cast(&sigVec[0].v), cast(&plan->coeffVec[0].v), plan->n);
+	return 0;
+}
+
+/*
+	aggSig = sum_i r_i sigVec[i], aggPub = sum_i r_i pubVec[i] for i in [0, n)
+	r_i is randVec[randSize * i, randSize * (i + 1))
+*/
+void sameMsgCombinedSub(G *aggSig, Gother *aggPub, const G *sigVec, const Gother *pubVec, const char *randVec, size_t randSize, size_t n)
+{
+	BLS_TRACE_SCOPE(BLS_PHASE_WORKER, n);
+	const size_t N = 32;
+	G sVec[N];
+	Gother pVec[N];
+	Fr rVec[N];
+	aggSig->clear();
+	aggPub->clear();
+	size_t pos = 0;
+	while (pos < n) {
+		const size_t m = fp::min_<size_t>(n - pos, N);
+		for (size_t i = 0; i < m; i++) {
+			bool b;
+			rVec[i].setArray(&b, (const uint8_t *)&randVec[(pos + i) * randSize], randSize);
+			(void)b;
+			sVec[i] = sigVec[pos + i];
+			pVec[i] = pubVec[pos + i];
+		}
+		G T;
+		GmulVec(T, sVec, rVec, m);
+		*aggSig += T;
+		Gother T2;
+		GmulVec(T2, pVec, rVec, m);
+		*aggPub += T2;
+		pos += m;
+	}
+}
+
+// split [0, n) into threadN blocks for sameMsgCombinedSub
+void sameMsgCombined(G& aggSig, Gother& aggPub, const G *sigVec, const Gother *pubVec, const char *randVec, size_t randSize, size_t n, int threadN)
+{
+#ifdef BLS_MULTI_VERIFY_THREAD
+	const int maxThreadNum = 32;
+	if (threadN > maxThreadNum) threadN = maxThreadNum;
+	const size_t minN = 32;
+	if (threadN > 1 && n >= minN * 2) {
+		if (size_t(threadN) > n / minN) threadN = int(n / minN);
+		std::thread th[maxThreadNum];
+		G sigOut[maxThreadNum];
+		Gother pubOut[maxThreadNum];
+		size_t pos = 0;
+		for (int i = 0; i < threadN; i++) {
+			const size_t m = n * (i + 1) / threadN - pos;
+			th[i] = std::thread(sameMsgCombinedSub, &sigOut[i], &pubOut[i], sigVec + pos, pubVec + pos, randVec + randSize * pos, randSize, m);
+			pos += m;
+		}
+		aggSig.clear();
+		aggPub.clear();
+		BLS_TRACE_SCOPE(BLS_PHASE_JOIN, threadN);
+		for (int i = 0; i < threadN; i++) {
+			th[i].join();
+			aggSig += sigOut[i];
+			aggPub += pubOut[i];
+		}
+		return;
+	}
+#else
+	(void)threadN;
+#endif
+	sameMsgCombinedSub(&aggSig, &aggPub, sigVec, pubVec, randVec, randSize, n);
+}
+
+/*
+	set okVec[i] = 1 if sigVec[i] is the signature of Hm by pubVec[i] else 0 for i in [0, n)
+	by bisection of the failed combinations
+	return the number of valid signatures
+*/
+mclSize verifySameMsgSub(uint8_t *okVec, const G *sigVec, const Gother *pubVec, const G& Hm, const char *randVec, size_t randSize, size_t n, int threadN)
+{
+	G aggSig;
+	Gother aggPub;
+	sameMsgCombined(aggSig, aggPub, sigVec, pubVec, randVec, randSize, n, threadN);
+	if (verifyHashed(g_ctx, aggSig, aggPub, Hm)) {
+		// the zero public key is not valid as blsVerify
+		mclSize c = 0;
+		for (size_t i = 0; i < n; i++) {
+			okVec[i] = !pubVec[i].isZero();
+			c += okVec[i];
+		}
+		return c;
+	}
+	if (n == 1) {
+		okVec[0] = 0;
+		return 0;
+	}
+	const size_t h = n / 2;
+	return verifySameMsgSub(okVec, sigVec, pubVec, Hm, randVec, randSize, h, threadN)
+		+ verifySameMsgSub(okVec + h, sigVec + h, pubVec + h, Hm, randVec + randSize * h, randSize, n - h, threadN);
+}
+
+int blsSignatureRecoverRobust(blsSignature *sig, uint8_t *okVec, const blsSignature *sigVec, const blsPublicKey *pubVec, const blsId *idVec, mclSize n, mclSize k, const blsPublicKey *mpk, const void *msg, mclSize msgSize, const void *randVec, mclSize randSize)
+{
+	if (k == 0 || n < k) return -1;
+	const Gother& pub = *cast(&mpk->v);
+	if (pub.isZero()) return -1;
+	BLS_TRACE_SCOPE(BLS_PHASE_BATCH, n);
+	G& out = *cast(&sig->v);
+	const G *sv = cast(&sigVec[0].v);
+	const Fr *S = cast(&idVec[0].v);
+	G Hm;
+	hashAndMapToG(g_ctx, Hm, msg, msgSize);
+	// the first k shares are valid in the common case ; recoverMT fails if they have zero or the same ids
+	if (recoverMT(out, sv, S, 0, k, 1) && verifyHashed(g_ctx, out, pub, Hm)) {
+		memset(okVec, 2, n);
+		return 0;
+	}
+	if (verifySameMsgSub(okVec, sv, cast(&pubVec[0].v), Hm, (const char*)randVec, randSize, n, 1) < k) return -1;
+	/*
+		recover from the first k valid shares of nonzero and distinct ids
+		the other valid shares before them are marked by 2 while recoverMT uses okVec as the mask
+	*/
+	size_t end = 0;
+	size_t c = 0;
+	for (; end < n && c < k; end++) {
+		if (okVec[end] != 1) continue;
+		bool use = !S[end].isZero();
+		for (size_t j = 0; use && j < end; j++) {
+			if (okVec[j] == 1 && S[j] == S[end]) use = false;
+		}
+		if (use) {
+			c++;
+		} else {
+			okVec[end] = 2;
+		}
+	}
+	const bool ok = c == k && recoverMT(out, sv, S, okVec, end, 1);
+	for (size_t i = 0; i < end; i++) {
+		if (okVec[i] == 2) okVec[i] = 1;
+	}
+	if (!ok) return -1;
+	return verifyHashed(g_ctx, out, pub, Hm) ? 0 : -1;
+}
+
+mclSize blsVerifySameMessageVec(uint8_t *okVec, const blsSignature *sigVec, const blsPublicKey *pubVec, mclSize n, const void *msg, mclSize msgSize, const void *randVec, mclSize randSize, int threadN)
+{
+	if (n == 0) return 0;
+	BLS_TRACE_SCOPE(BLS_PHASE_BATCH, n);
+	G Hm;
+	hashAndMapToG(g_ctx, Hm, msg, msgSize);
+	return verifySameMsgSub(okVec, cast(&sigVec[0].v), cast(&pubVec[0].v), Hm, (const char*)randVec, randSize, n, threadN);
+}
+
+int blsGetStats(blsStats *stats)
+{
+#ifdef BLS_USE_STATS
+	bls_stats::get(stats);
+	return 0;
+#else
+	memset(stats, 0, sizeof(*stats));
+	return -1;
+#endif
+}
+
+void blsResetStats(void)
+{
+#ifdef BLS_USE_STATS
+	bls_stats::reset();
 #endif
+}
 
+const char *blsGetStatName(int kind)
+{
+	return bls_stats::getName(kind);
+}
+
+mclSize blsStatsToText(char *buf, mclSize maxBufSize, const blsStats *stats)
+{
+	return bls_stats::toText(buf, maxBufSize, stats);
+}
+
+int blsSetTraceCallback(blsTraceCallback f, void *self)
+{
+	bls_trace::setHook(f, self);
+	return 0;
+}
+
+int blsClearTraceCallback(blsTraceCallback f, void *self)
+{
+	const bls_trace::Hook expected = { f, self };
+	return bls_trace::setHook(0, 0, &expected) ? 0 : -1;
+}
+
+const char *blsGetTracePhaseName(int phase)
+{
+	return bls_trace::getName(phase);
+}
+
+#endif
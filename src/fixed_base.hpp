@@ -0,0 +1,196 @@
+#pragma once
+/*
+	fixed-base scalar multiplication by a precomputed table
+	an odd k < 2^bitSize is recoded into d = ceil(bitSize / w) signed odd digits
+	u_i = 2 b_i + 1 - 2^w (i < d - 1), u_(d-1) = 2 b_(d-1) + 1
+	where b_i = (k >> (w i + 1)) & (2^w - 1), then k = sum_i u_i 2^(w i)
+	tbl[i][j] = (2j + 1) 2^(w i) P for i < d, j < 2^(w - 1)
+	kP = sum_i sign(u_i) tbl[i][(|u_i| - 1) / 2]
+	every digit is not zero and every row is scanned entirely, so the sequence of operations does not depend on k
+	an even k is replaced by r - k and the result is negated
+*/
+#include <stdint.h>
+#include <string.h>
+
+/*
+	the maximum window size
+	a table of window w has ceil(bitSize / w) 2^(w - 1) affine points
+*/
+#ifndef BLS_FIXED_BASE_MAX_WINDOW
+	#if defined(__EMSCRIPTEN__) || defined(__wasm__)
+		#define BLS_FIXED_BASE_MAX_WINDOW 4
+	#else
+		#define BLS_FIXED_BASE_MAX_WINDOW 6
+	#endif
+#endif
+
+namespace bls_fixed_base {
+
+template<class G, class Fr>
+class TableT {
+	typedef typename G::Fp F;
+	typedef mcl::Unit Unit;
+	struct Point {
+		F x, y;
+	};
+	static const size_t maxW = BLS_FIXED_BASE_MAX_WINDOW;
+	static const size_t maxBitSize = sizeof(Fr) * 8;
+	// the number of points increases with w
+	static const size_t maxPointN = ((maxBitSize + maxW - 1) / maxW) << (maxW - 1);
+	static const size_t minW = 2;
+	Point tbl_[maxPointN];
+	G base_;
+	size_t w_; // 0 if not initialized
+	size_t d_;
+	size_t bitSize_;
+	static const size_t unitN = sizeof(Point) / sizeof(Unit);
+	// out = tbl[i][j] for the secret j by scanning all entries of the row i
+	void lookup(Point& out, size_t i, Unit j) const
+	{
+		const size_t h = size_t(1) << (w_ - 1);
+		const Unit *src = (const Unit*)&tbl_[i * h];
+		Unit *dst = (Unit*)&out;
+		for (size_t k = 0; k < unitN; k++) dst[k] = 0;
+		for (size_t jj = 0; jj < h; jj++) {
+			const Unit mask = Unit(0) - Unit((Unit(jj) ^ j) == 0);
+			for (size_t k = 0; k < unitN; k++) dst[k] |= src[k] & mask;
+			src += unitN;
+		}
+	}
+	// y = neg ? -y : y for the secret neg
+	static void condNeg(F& y, Unit neg)
+	{
+		F ny;
+		F::neg(ny, y);
+		const Unit mask = Unit(0) - neg;
+		Unit *p = (Unit*)&y;
+		const Unit *q = (const Unit*)&ny;
+		for (size_t k = 0; k < sizeof(F) / sizeof(Unit); k++) {
+			p[k] = (p[k] & ~mask) | (q[k] & mask);
+		}
+	}
+	static Unit getBits(const uint8_t *k, size_t kSize, size_t pos, size_t w)
+	{
+		Unit v = 0;
+		for (size_t i = 0; i < w; i++) {
+			const size_t bit = pos + i;
+			if (bit / 8 < kSize) v |= Unit((k[bit / 8] >> (bit % 8)) & 1) << i;
+		}
+		return v;
+	}
+public:
+	TableT() : w_(0), d_(0), bitSize_(0) {}
+	static size_t getMaxWindow() { return maxW; }
+	size_t getWindow() const { return w_; }
+	bool isInitialized() const { return w_ > 0; }
+	// return true if the table is made for P
+	bool isBase(const G& P) const { return w_ > 0 && base_ == P; }
+	void clear() { w_ = 0; }
+	/*
+		make the table of w for P
+		return false if w is not in [2, getMaxWindow()]
+	*/
+	bool init(const G& P, size_t w)
+	{
+		w_ = 0;
+		if (w < minW || w > maxW) return false;
+		bitSize_ = Fr::getBitSize();
+		d_ = (bitSize_ + w - 1) / w;
+		const size_t h = size_t(1) << (w - 1);
+		G base = P;
+		G tmp[size_t(1) << (maxW - 1)];
+		G ntmp[size_t(1) << (maxW - 1)];
+		for (size_t i = 0; i < d_; i++) {
+			// base = 2^(w i) P
+			G base2;
+			G::dbl(base2, base);
+			tmp[0] = base;
+			for (size_t j = 1; j < h; j++) {
+				G::add(tmp[j], tmp[j - 1], base2);
+			}
+			G::normalizeVec(ntmp, tmp, h);
+			for (size_t j = 0; j < h; j++) {
+				tbl_[i * h + j].x = ntmp[j].x;
+				tbl_[i * h + j].y = ntmp[j].y;
+			}
+			for (size_t j = 0; j < w; j++) {
+				G::dbl(base, base);
+			}
+		}
+		base_ = P;
+		w_ = w;
+		return true;
+	}
+	// the number of units of the table made by init
+	size_t getTableUnitN() const { return w_ > 0 ? (d_ << (w_ - 1)) * unitN : 0; }
+	// the raw table to be embedded by misc/precompute.cpp
+	const Unit *getTable() const { return (const Unit*)tbl_; }
+	/*
+		set the table of w for P made by init and getTable
+		return false if w is not in [2, getMaxWindow()] or tblN is not the size of the table
+	*/
+	bool setTable(const G& P, size_t w, const Unit *tbl, size_t tblN)
+	{
+		w_ = 0;
+		if (w < minW || w > maxW) return false;
+		bitSize_ = Fr::getBitSize();
+		d_ = (bitSize_ + w - 1) / w;
+		if (tblN != ((d_ << (w - 1)) * unitN)) return false;
+		Unit *dst = (Unit*)tbl_;
+		for (size_t i = 0; i < tblN; i++) dst[i] = tbl[i];
+		base_ = P;
+		w_ = w;
+		return true;
+	}
+	// Q = k P
+	void mul(G& Q, const Fr& k) const
+	{
+		if (k.isZero()) {
+			Q.clear();
+			return;
+		}
+		uint8_t buf[sizeof(Fr)];
+		uint8_t nbuf[sizeof(Fr)];
+		memset(buf, 0, sizeof(buf));
+		memset(nbuf, 0, sizeof(nbuf));
+		k.getLittleEndian(buf, sizeof(buf));
+		Fr nk;
+		Fr::neg(nk, k);
+		nk.getLittleEndian(nbuf, sizeof(nbuf));
+		// use r - k if k is even
+		const Unit even = Unit(~buf[0] & 1);
+		const uint8_t mask = uint8_t(0) - uint8_t(even);
+		for (size_t i = 0; i < sizeof(buf); i++) {
+			buf[i] = uint8_t((buf[i] & ~mask) | (nbuf[i] & mask));
+		}
+		const size_t w = w_;
+		const Unit half = Unit(1) << (w - 1);
+		Point pt;
+		for (size_t i = 0; i < d_; i++) {
+			const Unit b = getBits(buf, sizeof(buf), w * i + 1, w);
+			Unit neg = 0;
+			Unit j = b;
+			if (i < d_ - 1) {
+				// u = 2b + 1 - 2^w is positive iff b >= 2^(w - 1)
+				neg = (b >> (w - 1)) ^ 1;
+				j = (b ^ (Unit(0) - neg)) & (half - 1);
+			}
+			lookup(pt, i, j);
+			condNeg(pt.y, neg);
+			if (i == 0) {
+				Q.x = pt.x;
+				Q.y = pt.y;
+				Q.z = 1;
+			} else {
+				G T;
+				T.x = pt.x;
+				T.y = pt.y;
+				T.z = 1;
+				G::add(Q, Q, T);
+			}
+		}
+		condNeg(Q.y, even);
+	}
+};
+
+} // bls_fixed_base
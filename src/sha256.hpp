@@ -0,0 +1,572 @@
+#pragma once
+/*
+	SHA-256 which finalizes many messages sharing the same prefix at once
+	Sha256 ; streaming hash of the prefix (the midstate and the remaining bytes)
+	digestVec ; SHA-256(prefix || suffix_i) for n suffixes by multi-buffer kernels
+	the kernels (AVX-512 16 lanes, AVX2 8 lanes, SHA-NI, scalar) are selected at runtime
+	define BLS_SHA256_NO_SIMD to use only the scalar kernel, or call setKernelMask at runtime
+*/
+#include <stdint.h>
+#include <string.h>
+#if __cplusplus >= 201103L
+	#include <atomic>
+#endif
+
+#if !defined(BLS_SHA256_NO_SIMD) && defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__)) && !defined(__EMSCRIPTEN__) && !defined(__wasm__)
+	#define BLS_SHA256_X86
+	#include <immintrin.h>
+	#include <cpuid.h>
+#endif
+
+namespace bls_sha256 {
+
+static const uint32_t K[64] = {
+	0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+	0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+	0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+	0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+	0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+	0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+	0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+	0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+static const uint32_t IV[8] = {
+	0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+};
+
+inline uint32_t load32be(const uint8_t *p)
+{
+	return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | p[3];
+}
+
+inline void store32be(uint8_t *p, uint32_t x)
+{
+	p[0] = uint8_t(x >> 24);
+	p[1] = uint8_t(x >> 16);
+	p[2] = uint8_t(x >> 8);
+	p[3] = uint8_t(x);
+}
+
+inline uint32_t rotr(uint32_t x, int n) { return (x >> n) | (x << (32 - n)); }
+
+// h = compress(h, w) for the message words w[16]
+inline void compressW(uint32_t h[8], const uint32_t w0[16])
+{
+	uint32_t w[64];
+	for (int t = 0; t < 16; t++) w[t] = w0[t];
+	for (int t = 16; t < 64; t++) {
+		const uint32_t s0 = rotr(w[t - 15], 7) ^ rotr(w[t - 15], 18) ^ (w[t - 15] >> 3);
+		const uint32_t s1 = rotr(w[t - 2], 17) ^ rotr(w[t - 2], 19) ^ (w[t - 2] >> 10);
+		w[t] = w[t - 16] + s0 + w[t - 7] + s1;
+	}
+	uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4], f = h[5], g = h[6], hh = h[7];
+	for (int t = 0; t < 64; t++) {
+		const uint32_t t1 = hh + (rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25)) + ((e & f) ^ (~e & g)) + K[t] + w[t];
+		const uint32_t t2 = (rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+		hh = g; g = f; f = e; e = d + t1;
+		d = c; c = b; b = a; a = t1 + t2;
+	}
+	h[0] += a; h[1] += b; h[2] += c; h[3] += d;
+	h[4] += e; h[5] += f; h[6] += g; h[7] += hh;
+}
+
+inline void compressScalar(uint32_t h[8], const uint8_t *p, size_t blockN)
+{
+	for (size_t i = 0; i < blockN; i++) {
+		uint32_t w[16];
+		for (int t = 0; t < 16; t++) w[t] = load32be(p + t * 4);
+		compressW(h, w);
+		p += 64;
+	}
+}
+
+#ifdef BLS_SHA256_X86
+__attribute__((target("sha,sse4.1")))
+inline void compressShaNi(uint32_t h[8], const uint8_t *p, size_t blockN)
+{
+	const __m128i mask = _mm_set_epi64x(0x0c0d0e0f08090a0bull, 0x0405060700010203ull);
+	__m128i tmp = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)&h[0]), 0xb1); // CDAB
+	__m128i s1 = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)&h[4]), 0x1b); // EFGH
+	__m128i s0 = _mm_alignr_epi8(tmp, s1, 8); // ABEF
+	s1 = _mm_blend_epi16(s1, tmp, 0xf0); // CDGH
+	for (size_t i = 0; i < blockN; i++) {
+		const __m128i s0save = s0;
+		const __m128i s1save = s1;
+		__m128i m[4];
+		for (int j = 0; j < 16; j++) {
+			if (j < 4) {
+				m[j] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(p + j * 16)), mask);
+			} else {
+				__m128i t = _mm_sha256msg1_epu32(m[j & 3], m[(j + 1) & 3]);
+				t = _mm_add_epi32(t, _mm_alignr_epi8(m[(j + 3) & 3], m[(j + 2) & 3], 4));
+				m[j & 3] = _mm_sha256msg2_epu32(t, m[(j + 3) & 3]);
+			}
+			__m128i x = _mm_add_epi32(m[j & 3], _mm_loadu_si128((const __m128i*)&K[j * 4]));
+			s1 = _mm_sha256rnds2_epu32(s1, s0, x);
+			x = _mm_shuffle_epi32(x, 0x0e);
+			s0 = _mm_sha256rnds2_epu32(s0, s1, x);
+		}
+		s0 = _mm_add_epi32(s0, s0save);
+		s1 = _mm_add_epi32(s1, s1save);
+		p += 64;
+	}
+	tmp = _mm_shuffle_epi32(s0, 0x1b); // FEBA
+	s1 = _mm_shuffle_epi32(s1, 0xb1); // DCHG
+	s0 = _mm_blend_epi16(tmp, s1, 0xf0); // DCBA
+	s1 = _mm_alignr_epi8(s1, tmp, 8); // HGFE
+	_mm_storeu_si128((__m128i*)&h[0], s0);
+	_mm_storeu_si128((__m128i*)&h[4], s1);
+}
+
+template<int n>
+__attribute__((target("avx2")))
+inline __m256i rotrX8(__m256i x) { return _mm256_or_si256(_mm256_srli_epi32(x, n), _mm256_slli_epi32(x, 32 - n)); }
+
+/*
+	8 lanes ; st[r][lane] is the r-th word of the state, w[t][lane] is the t-th message word
+*/
+__attribute__((target("avx2")))
+inline void compressX8(uint32_t st[8][8], const uint32_t w0[16][8])
+{
+	__m256i w[16];
+	for (int t = 0; t < 16; t++) w[t] = _mm256_loadu_si256((const __m256i*)w0[t]);
+	__m256i s[8];
+	for (int r = 0; r < 8; r++) s[r] = _mm256_loadu_si256((const __m256i*)st[r]);
+	__m256i a = s[0], b = s[1], c = s[2], d = s[3], e = s[4], f = s[5], g = s[6], h = s[7];
+	for (int t = 0; t < 64; t++) {
+		if (t >= 16) {
+			const __m256i x = w[(t - 15) & 15];
+			const __m256i y = w[(t - 2) & 15];
+			const __m256i s0 = _mm256_xor_si256(_mm256_xor_si256(rotrX8<7>(x), rotrX8<18>(x)), _mm256_srli_epi32(x, 3));
+			const __m256i s1 = _mm256_xor_si256(_mm256_xor_si256(rotrX8<17>(y), rotrX8<19>(y)), _mm256_srli_epi32(y, 10));
+			w[t & 15] = _mm256_add_epi32(_mm256_add_epi32(w[t & 15], s0), _mm256_add_epi32(w[(t - 7) & 15], s1));
+		}
+		const __m256i S1 = _mm256_xor_si256(_mm256_xor_si256(rotrX8<6>(e), rotrX8<11>(e)), rotrX8<25>(e));
+		const __m256i ch = _mm256_xor_si256(_mm256_and_si256(e, f), _mm256_andnot_si256(e, g));
+		const __m256i t1 = _mm256_add_epi32(_mm256_add_epi32(_mm256_add_epi32(h, S1), _mm256_add_epi32(ch, w[t & 15])), _mm256_set1_epi32(int(K[t])));
+		const __m256i S0 = _mm256_xor_si256(_mm256_xor_si256(rotrX8<2>(a), rotrX8<13>(a)), rotrX8<22>(a));
+		const __m256i maj = _mm256_or_si256(_mm256_and_si256(a, b), _mm256_and_si256(c, _mm256_or_si256(a, b)));
+		h = g; g = f; f = e; e = _mm256_add_epi32(d, t1);
+		d = c; c = b; b = a; a = _mm256_add_epi32(t1, _mm256_add_epi32(S0, maj));
+	}
+	s[0] = _mm256_add_epi32(s[0], a); s[1] = _mm256_add_epi32(s[1], b);
+	s[2] = _mm256_add_epi32(s[2], c); s[3] = _mm256_add_epi32(s[3], d);
+	s[4] = _mm256_add_epi32(s[4], e); s[5] = _mm256_add_epi32(s[5], f);
+	s[6] = _mm256_add_epi32(s[6], g); s[7] = _mm256_add_epi32(s[7], h);
+	for (int r = 0; r < 8; r++) _mm256_storeu_si256((__m256i*)st[r], s[r]);
+}
+
+// 16 lanes version of compressX8
+#if defined(__GNUC__) && !defined(__clang__)
+	// the intrinsics of some versions of gcc use _mm512_undefined_epi32() as the passthrough operand
+	#pragma GCC diagnostic push
+	#pragma GCC diagnostic ignored "-Wuninitialized"
+	#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+__attribute__((target("avx512f")))
+inline void compressX16(uint32_t st[8][16], const uint32_t w0[16][16])
+{
+	__m512i w[16];
+	for (int t = 0; t < 16; t++) w[t] = _mm512_loadu_si512(w0[t]);
+	__m512i s[8];
+	for (int r = 0; r < 8; r++) s[r] = _mm512_loadu_si512(st[r]);
+	__m512i a = s[0], b = s[1], c = s[2], d = s[3], e = s[4], f = s[5], g = s[6], h = s[7];
+	for (int t = 0; t < 64; t++) {
+		if (t >= 16) {
+			const __m512i x = w[(t - 15) & 15];
+			const __m512i y = w[(t - 2) & 15];
+			const __m512i s0 = _mm512_ternarylogic_epi32(_mm512_ror_epi32(x, 7), _mm512_ror_epi32(x, 18), _mm512_srli_epi32(x, 3), 0x96);
+			const __m512i s1 = _mm512_ternarylogic_epi32(_mm512_ror_epi32(y, 17), _mm512_ror_epi32(y, 19), _mm512_srli_epi32(y, 10), 0x96);
+			w[t & 15] = _mm512_add_epi32(_mm512_add_epi32(w[t & 15], s0), _mm512_add_epi32(w[(t - 7) & 15], s1));
+		}
+		const __m512i S1 = _mm512_ternarylogic_epi32(_mm512_ror_epi32(e, 6), _mm512_ror_epi32(e, 11), _mm512_ror_epi32(e, 25), 0x96);
+		const __m512i ch = _mm512_ternarylogic_epi32(e, f, g, 0xca);
+		const __m512i t1 = _mm512_add_epi32(_mm512_add_epi32(_mm512_add_epi32(h, S1), _mm512_add_epi32(ch, w[t & 15])), _mm512_set1_epi32(int(K[t])));
+		const __m512i S0 = _mm512_ternarylogic_epi32(_mm512_ror_epi32(a, 2), _mm512_ror_epi32(a, 13), _mm512_ror_epi32(a, 22), 0x96);
+		const __m512i maj = _mm512_ternarylogic_epi32(a, b, c, 0xe8);
+		h = g; g = f; f = e; e = _mm512_add_epi32(d, t1);
+		d = c; c = b; b = a; a = _mm512_add_epi32(t1, _mm512_add_epi32(S0, maj));
+	}
+	s[0] = _mm512_add_epi32(s[0], a); s[1] = _mm512_add_epi32(s[1], b);
+	s[2] = _mm512_add_epi32(s[2], c); s[3] = _mm512_add_epi32(s[3], d);
+	s[4] = _mm512_add_epi32(s[4], e); s[5] = _mm512_add_epi32(s[5], f);
+	s[6] = _mm512_add_epi32(s[6], g); s[7] = _mm512_add_epi32(s[7], h);
+	for (int r = 0; r < 8; r++) _mm512_storeu_si512(st[r], s[r]);
+}
+#if defined(__GNUC__) && !defined(__clang__)
+	#pragma GCC diagnostic pop
+#endif
+#endif
+
+enum {
+	KernelScalar,
+	KernelShaNi,
+	KernelAvx2,
+	KernelAvx512,
+};
+
+inline int detectKernelAvailable()
+{
+#ifdef BLS_SHA256_X86
+	unsigned int a, b, c, d;
+	if (!__get_cpuid(1, &a, &b, &c, &d)) return 0;
+	const bool osxsave = (c >> 27) & 1;
+	unsigned int xcr0 = 0;
+	if (osxsave) {
+		unsigned int edx;
+		__asm__ volatile("xgetbv" : "=a"(xcr0), "=d"(edx) : "c"(0));
+	}
+	if (!__get_cpuid_count(7, 0, &a, &b, &c, &d)) return 0;
+	int ret = 0;
+	if ((b >> 29) & 1) ret |= 1 << KernelShaNi;
+	if ((xcr0 & 0x6) == 0x6 && ((b >> 5) & 1)) ret |= 1 << KernelAvx2;
+	if ((xcr0 & 0xe6) == 0xe6 && ((b >> 16) & 1)) ret |= 1 << KernelAvx512;
+	return ret;
+#else
+	return 0;
+#endif
+}
+
+// bit flags of available kernels ; the static is initialized once by its initializer
+inline int getKernelAvailable()
+{
+	static const int available = detectKernelAvailable();
+	return available;
+}
+
+/*
+	limit the kernels to the bit flags of mask (all by default)
+	setKernelMask(1 << KernelAvx2) forces the AVX2 kernel if it is available
+	setKernelMask(0) forces the scalar one
+*/
+#if __cplusplus >= 201103L
+inline std::atomic<int>& getKernelMaskVar()
+{
+	static std::atomic<int> mask(~0);
+	return mask;
+}
+inline void setKernelMask(int mask) { getKernelMaskVar().store(mask, std::memory_order_relaxed); }
+inline int getKernelMask() { return getKernelMaskVar().load(std::memory_order_relaxed); }
+#else
+// set it while no thread is hashing
+inline int& getKernelMaskVar()
+{
+	static int mask = ~0;
+	return mask;
+}
+inline void setKernelMask(int mask) { getKernelMaskVar() = mask; }
+inline int getKernelMask() { return getKernelMaskVar(); }
+#endif
+
+// bit flags of the kernels to be used
+inline int getKernel()
+{
+	return getKernelAvailable() & getKernelMask();
+}
+
+inline void compress(uint32_t h[8], const uint8_t *p, size_t blockN)
+{
+#ifdef BLS_SHA256_X86
+	if (getKernel() & (1 << KernelShaNi)) {
+		compressShaNi(h, p, blockN);
+		return;
+	}
+#endif
+	compressScalar(h, p, blockN);
+}
+
+class Sha256;
+class ExpandMsgXmd;
+void digestVec(uint8_t *mdVec, const Sha256& h0, const void *sufVec, size_t sufSize, size_t n);
+
+class Sha256 {
+	uint32_t h_[8];
+	uint8_t buf_[64];
+	size_t bufSize_;
+	uint64_t totalSize_;
+	friend void digestVec(uint8_t *mdVec, const Sha256& h0, const void *sufVec, size_t sufSize, size_t n);
+	friend class ExpandMsgXmd;
+public:
+	Sha256() { clear(); }
+	void clear()
+	{
+		memcpy(h_, IV, sizeof(h_));
+		bufSize_ = 0;
+		totalSize_ = 0;
+	}
+	void update(const void *buf, size_t size)
+	{
+		const uint8_t *p = (const uint8_t*)buf;
+		totalSize_ += size;
+		if (bufSize_ > 0) {
+			size_t m = 64 - bufSize_;
+			if (m > size) m = size;
+			memcpy(buf_ + bufSize_, p, m);
+			bufSize_ += m;
+			p += m;
+			size -= m;
+			if (bufSize_ < 64) return;
+			compress(h_, buf_, 1);
+			bufSize_ = 0;
+		}
+		const size_t blockN = size / 64;
+		if (blockN > 0) {
+			compress(h_, p, blockN);
+			p += blockN * 64;
+			size -= blockN * 64;
+		}
+		memcpy(buf_, p, size);
+		bufSize_ = size;
+	}
+	// md = SHA-256 of all data given to update
+	void digest(uint8_t md[32]) const
+	{
+		digestVec(md, *this, 0, 0, 1);
+	}
+};
+
+/*
+	the last blocks of the message which has remaining bytes rem[0, remSize), suf[0, sufSize) and totalSize bytes
+	blk must have getLastBlockN(remSize + sufSize) * 64 bytes
+	return the number of blocks
+*/
+inline size_t getLastBlockN(size_t size) { return (size + 9 + 63) / 64; }
+inline size_t makeLastBlocks(uint8_t *blk, const uint8_t *rem, size_t remSize, const uint8_t *suf, size_t sufSize, uint64_t totalSize)
+{
+	memcpy(blk, rem, remSize);
+	memcpy(blk + remSize, suf, sufSize);
+	size_t pos = remSize + sufSize;
+	blk[pos++] = 0x80;
+	const size_t blockN = getLastBlockN(remSize + sufSize);
+	memset(blk + pos, 0, blockN * 64 - 8 - pos);
+	const uint64_t bitSize = totalSize * 8;
+	store32be(blk + blockN * 64 - 8, uint32_t(bitSize >> 32));
+	store32be(blk + blockN * 64 - 4, uint32_t(bitSize));
+	return blockN;
+}
+
+#ifdef BLS_SHA256_X86
+/*
+	stVec[8 * i, 8 * (i + 1)) = compress(stVec[8 * i, 8 * (i + 1)), blkVec[i][0, 64 * blockN)) for i = 0, ..., n-1 by L lanes
+	L = 8 or 16
+*/
+template<size_t L, class Compress>
+void compressVecX(uint32_t *stVec, const uint8_t *const *blkVec, size_t blockN, size_t n, Compress compressX)
+{
+	uint32_t st[8][L];
+	uint32_t w[16][L];
+	for (size_t pos = 0; pos < n; pos += L) {
+		const size_t m = n - pos < L ? n - pos : L;
+		// unused lanes compute the last one again
+		for (size_t j = 0; j < L; j++) {
+			const size_t i = pos + (j < m ? j : m - 1);
+			for (int r = 0; r < 8; r++) st[r][j] = stVec[i * 8 + r];
+		}
+		for (size_t b = 0; b < blockN; b++) {
+			for (size_t j = 0; j < L; j++) {
+				const uint8_t *p = blkVec[pos + (j < m ? j : m - 1)] + b * 64;
+				for (int t = 0; t < 16; t++) w[t][j] = load32be(p + t * 4);
+			}
+			compressX(st, w);
+		}
+		for (size_t j = 0; j < m; j++) {
+			for (int r = 0; r < 8; r++) stVec[(pos + j) * 8 + r] = st[r][j];
+		}
+	}
+}
+#endif
+
+/*
+	stVec[8 * i, 8 * (i + 1)) = compress(stVec[8 * i, 8 * (i + 1)), blkVec[i][0, 64 * blockN)) for i = 0, ..., n-1
+	use a multi-buffer kernel if it is faster than SHA-NI for n
+*/
+inline void compressVec(uint32_t *stVec, const uint8_t *const *blkVec, size_t blockN, size_t n)
+{
+#ifdef BLS_SHA256_X86
+	const int available = getKernel();
+	if ((available & (1 << KernelAvx512)) && n >= 8) {
+		compressVecX<16>(stVec, blkVec, blockN, n, compressX16);
+		return;
+	}
+	if ((available & (1 << KernelAvx2)) && !(available & (1 << KernelShaNi)) && n >= 4) {
+		compressVecX<8>(stVec, blkVec, blockN, n, compressX8);
+		return;
+	}
+#endif
+	for (size_t i = 0; i < n; i++) {
+		compress(stVec + i * 8, blkVec[i], blockN);
+	}
+}
+
+inline void storeDigest(uint8_t md[32], const uint32_t h[8])
+{
+	for (int r = 0; r < 8; r++) store32be(md + r * 4, h[r]);
+}
+
+/*
+	mdVec[32 * i, 32 * (i + 1)) = SHA-256(prefix || sufVec[sufSize * i, sufSize * (i + 1))) for i = 0, ..., n-1
+	where prefix is the data given to h0
+	@note h0 is not changed
+*/
+inline void digestVec(uint8_t *mdVec, const Sha256& h0, const void *sufVec, size_t sufSize, size_t n)
+{
+	const uint8_t *suf = (const uint8_t*)sufVec;
+	const uint64_t totalSize = h0.totalSize_ + sufSize;
+	// the last blocks of a short suffix are made on the stack
+	if (h0.bufSize_ + sufSize + 9 <= 128) {
+		const size_t N = 16;
+		uint8_t blk[N][128];
+		const uint8_t *blkVec[N] = {};
+		uint32_t stVec[N * 8];
+		for (size_t pos = 0; pos < n; pos += N) {
+			const size_t m = n - pos < N ? n - pos : N;
+			size_t blockN = 0;
+			for (size_t i = 0; i < m; i++) {
+				blockN = makeLastBlocks(blk[i], h0.buf_, h0.bufSize_, suf + sufSize * (pos + i), sufSize, totalSize);
+				blkVec[i] = blk[i];
+				memcpy(stVec + i * 8, h0.h_, sizeof(h0.h_));
+			}
+			compressVec(stVec, blkVec, blockN, m);
+			for (size_t i = 0; i < m; i++) {
+				storeDigest(mdVec + (pos + i) * 32, stVec + i * 8);
+			}
+		}
+		return;
+	}
+	for (size_t i = 0; i < n; i++) {
+		Sha256 h = h0;
+		h.update(suf + sufSize * i, sufSize);
+		h.digest(mdVec + i * 32);
+	}
+}
+
+/*
+	expand_message_xmd of irtf-cfrg-hash-to-curve with SHA-256 for a fixed DST
+	b_0 = H(Z_pad || msg || I2OSP(len, 2) || I2OSP(0, 1) || DST_prime)
+	b_1 = H(b_0 || I2OSP(1, 1) || DST_prime)
+	b_i = H((b_0 ^ b_(i-1)) || I2OSP(i, 1) || DST_prime)
+	the midstate after Z_pad (one zero block) and DST_prime are computed once
+	expandVec runs the compressions of many messages in the lanes of compressVec
+*/
+class ExpandMsgXmd {
+public:
+	static const size_t maxDstSize = 255;
+	static const size_t maxOutSize = 255 * 32;
+private:
+	Sha256 z_; // after absorbing Z_pad
+	uint8_t dstPrime_[maxDstSize + 1]; // DST || I2OSP(len(DST), 1)
+	size_t dstPrimeSize_;
+	struct OneMsg {
+		const char *msg;
+		size_t size;
+		const char *get(size_t) const { return msg; }
+		size_t getSize(size_t) const { return size; }
+	};
+	template<class Msgs>
+	struct SkipMsg {
+		const Msgs& msgs;
+		size_t pos;
+		SkipMsg(const Msgs& msgs, size_t pos) : msgs(msgs), pos(pos) {}
+		const char *get(size_t i) const { return msgs.get(pos + i); }
+		size_t getSize(size_t i) const { return msgs.getSize(pos + i); }
+	};
+	static const size_t N = 16;
+	// expand the messages of the same size in the lanes [0, m)
+	template<class Msgs>
+	void expandSub(uint8_t *outVec, size_t outSize, const Msgs& msgs, size_t m) const
+	{
+		const uint8_t *blkVec[N] = {};
+		uint32_t stVec[N * 8];
+		// the last blocks of b_0 have at most 63 + 3 + 256 + 9 bytes
+		uint8_t blk[N][6 * 64];
+		uint8_t suf[3 + maxDstSize + 1];
+		suf[0] = uint8_t(outSize >> 8);
+		suf[1] = uint8_t(outSize);
+		suf[2] = 0;
+		memcpy(suf + 3, dstPrime_, dstPrimeSize_);
+		const size_t msgSize = msgs.getSize(0);
+		const size_t fullBlockN = msgSize / 64;
+		const size_t remSize = msgSize % 64;
+		const uint64_t totalSize = 64 + msgSize + 3 + dstPrimeSize_;
+		for (size_t i = 0; i < m; i++) {
+			memcpy(stVec + i * 8, z_.h_, sizeof(z_.h_));
+			blkVec[i] = (const uint8_t*)msgs.get(i);
+		}
+		compressVec(stVec, blkVec, fullBlockN, m);
+		size_t blockN = 0;
+		for (size_t i = 0; i < m; i++) {
+			blockN = makeLastBlocks(blk[i], blkVec[i] + fullBlockN * 64, remSize, suf, 3 + dstPrimeSize_, totalSize);
+			blkVec[i] = blk[i];
+		}
+		compressVec(stVec, blkVec, blockN, m);
+		uint8_t b0[N][32];
+		uint8_t bi[N][32];
+		for (size_t i = 0; i < m; i++) {
+			storeDigest(b0[i], stVec + i * 8);
+		}
+		const size_t ell = (outSize + 31) / 32;
+		for (size_t k = 1; k <= ell; k++) {
+			suf[0] = uint8_t(k);
+			memcpy(suf + 1, dstPrime_, dstPrimeSize_);
+			for (size_t i = 0; i < m; i++) {
+				uint8_t x[32];
+				for (size_t j = 0; j < 32; j++) {
+					x[j] = k == 1 ? b0[i][j] : uint8_t(b0[i][j] ^ bi[i][j]);
+				}
+				blockN = makeLastBlocks(blk[i], x, 32, suf, 1 + dstPrimeSize_, 32 + 1 + dstPrimeSize_);
+				memcpy(stVec + i * 8, IV, sizeof(IV));
+			}
+			compressVec(stVec, blkVec, blockN, m);
+			const size_t pos = (k - 1) * 32;
+			const size_t size = outSize - pos < 32 ? outSize - pos : 32;
+			for (size_t i = 0; i < m; i++) {
+				storeDigest(bi[i], stVec + i * 8);
+				memcpy(outVec + outSize * i + pos, bi[i], size);
+			}
+		}
+	}
+public:
+	ExpandMsgXmd() : dstPrimeSize_(0)
+	{
+		const uint8_t zero[64] = {};
+		z_.update(zero, sizeof(zero));
+		setDst("", 0);
+	}
+	// return false if dstSize > maxDstSize
+	bool setDst(const void *dst, size_t dstSize)
+	{
+		if (dstSize > maxDstSize) return false;
+		memcpy(dstPrime_, dst, dstSize);
+		dstPrime_[dstSize] = uint8_t(dstSize);
+		dstPrimeSize_ = dstSize + 1;
+		return true;
+	}
+	/*
+		outVec[outSize * i, outSize * (i + 1)) = expand_message_xmd(msgs[i], DST, outSize) for i = 0, ..., n-1
+		Msgs is an accessor of messages with get(i) and getSize(i)
+		return false if outSize is 0 or greater than maxOutSize
+	*/
+	template<class Msgs>
+	bool expandVec(uint8_t *outVec, size_t outSize, const Msgs& msgs, size_t n) const
+	{
+		if (outSize == 0 || outSize > maxOutSize) return false;
+		size_t pos = 0;
+		while (pos < n) {
+			// the lanes of one pass must have the messages of the same size
+			const size_t msgSize = msgs.getSize(pos);
+			size_t m = 1;
+			while (m < N && pos + m < n && msgs.getSize(pos + m) == msgSize) m++;
+			expandSub(outVec + outSize * pos, outSize, SkipMsg<Msgs>(msgs, pos), m);
+			pos += m;
+		}
+		return true;
+	}
+	bool expand(uint8_t *out, size_t outSize, const void *msg, size_t msgSize) const
+	{
+		OneMsg one = { (const char*)msg, msgSize };
+		return expandVec(out, outSize, one, 1);
+	}
+};
+
+} // bls_sha256
@@ -0,0 +1,226 @@
+#pragma once
+/*
+	counters and latency histograms of the hot paths for blsGetStats
+	they are collected if BLS_USE_STATS is defined (C++11 is required)
+	a thread adds to the shard selected by its thread_local index with relaxed atomics
+	so the threads made by the library seldom write the same cache line
+	the bucket i of the histogram counts the calls taking [2^i, 2^(i+1)) ns (the last one is unbounded)
+*/
+#include <stdint.h>
+#include <string.h>
+
+#ifdef BLS_USE_STATS
+#include <atomic>
+#include <chrono>
+#endif
+
+namespace bls_stats {
+
+static const size_t kindN = BLS_STAT_N;
+static const size_t bucketN = BLS_STATS_BUCKET_N;
+
+inline const char *getName(int kind)
+{
+	static const char *tbl[kindN] = {
+		"miller_loop",
+		"final_exp",
+		"hash_to_curve",
+		"subgroup_check",
+		"deserialize",
+		"mul",
+		"mul_vec",
+	};
+	if (kind < 0 || size_t(kind) >= kindN) return 0;
+	return tbl[kind];
+}
+
+// append text to buf[0, maxBufSize) ; the result is valid if ok()
+class Writer {
+	char *buf_;
+	size_t maxBufSize_;
+	size_t pos_;
+	bool ok_;
+public:
+	Writer(char *buf, size_t maxBufSize) : buf_(buf), maxBufSize_(maxBufSize), pos_(0), ok_(true) {}
+	void put(const char *s)
+	{
+		const size_t n = strlen(s);
+		// keep one byte for '\0'
+		if (!ok_ || pos_ + n >= maxBufSize_) {
+			ok_ = false;
+			return;
+		}
+		memcpy(buf_ + pos_, s, n);
+		pos_ += n;
+		buf_[pos_] = '\0';
+	}
+	void put(uint64_t x)
+	{
+		char tmp[24];
+		size_t n = sizeof(tmp) - 1;
+		tmp[n] = '\0';
+		do {
+			tmp[--n] = char('0' + x % 10);
+			x /= 10;
+		} while (x > 0);
+		put(tmp + n);
+	}
+	bool ok() const { return ok_; }
+	size_t size() const { return pos_; }
+};
+
+/*
+	Prometheus text format
+	bls_op_latency_ns is a histogram whose le is the upper bound of the bucket
+*/
+inline size_t toText(char *buf, size_t maxBufSize, const blsStats *stats)
+{
+	Writer w(buf, maxBufSize);
+	w.put("# TYPE bls_op_latency_ns histogram\n");
+	for (size_t k = 0; k < kindN; k++) {
+		const blsStatEntry& e = stats->v[k];
+		const char *name = getName(int(k));
+		uint64_t sum = 0;
+		for (size_t i = 0; i < bucketN; i++) {
+			sum += e.hist[i];
+			w.put("bls_op_latency_ns_bucket{op=\"");
+			w.put(name);
+			w.put("\",le=\"");
+			if (i == bucketN - 1) {
+				w.put("+Inf");
+			} else {
+				w.put(uint64_t(1) << (i + 1));
+			}
+			w.put("\"} ");
+			w.put(sum);
+			w.put("\n");
+		}
+		w.put("bls_op_latency_ns_sum{op=\"");
+		w.put(name);
+		w.put("\"} ");
+		w.put(e.totalNs);
+		w.put("\nbls_op_latency_ns_count{op=\"");
+		w.put(name);
+		w.put("\"} ");
+		w.put(e.count);
+		w.put("\n");
+	}
+	w.put("# TYPE bls_op_items_total counter\n");
+	for (size_t k = 0; k < kindN; k++) {
+		w.put("bls_op_items_total{op=\"");
+		w.put(getName(int(k)));
+		w.put("\"} ");
+		w.put(stats->v[k].itemN);
+		w.put("\n");
+	}
+	return w.ok() ? w.size() : 0;
+}
+
+#ifdef BLS_USE_STATS
+
+static const size_t shardN = 16;
+
+struct alignas(64) Shard {
+	std::atomic<uint64_t> count[kindN];
+	std::atomic<uint64_t> itemN[kindN];
+	std::atomic<uint64_t> totalNs[kindN];
+	std::atomic<uint64_t> hist[kindN][bucketN];
+};
+
+// zero-initialized as a static object
+inline Shard *getShardTbl()
+{
+	static Shard tbl[shardN];
+	return tbl;
+}
+
+inline Shard& getShard()
+{
+	static std::atomic<size_t> next(0);
+	static thread_local size_t idx = next.fetch_add(1, std::memory_order_relaxed) % shardN;
+	return getShardTbl()[idx];
+}
+
+inline size_t getBucket(uint64_t ns)
+{
+	size_t i = 0;
+	while (ns > 1 && i < bucketN - 1) {
+		ns >>= 1;
+		i++;
+	}
+	return i;
+}
+
+inline void add(int kind, uint64_t n, uint64_t ns)
+{
+	const std::memory_order o = std::memory_order_relaxed;
+	Shard& s = getShard();
+	s.count[kind].fetch_add(1, o);
+	s.itemN[kind].fetch_add(n, o);
+	s.totalNs[kind].fetch_add(ns, o);
+	s.hist[kind][getBucket(ns)].fetch_add(1, o);
+}
+
+// the sum of the shards ; the entries may be inconsistent while the other threads are running
+inline void get(blsStats *stats)
+{
+	const std::memory_order o = std::memory_order_relaxed;
+	memset(stats, 0, sizeof(*stats));
+	const Shard *tbl = getShardTbl();
+	for (size_t i = 0; i < shardN; i++) {
+		const Shard& s = tbl[i];
+		for (size_t k = 0; k < kindN; k++) {
+			blsStatEntry& e = stats->v[k];
+			e.count += s.count[k].load(o);
+			e.itemN += s.itemN[k].load(o);
+			e.totalNs += s.totalNs[k].load(o);
+			for (size_t j = 0; j < bucketN; j++) {
+				e.hist[j] += s.hist[k][j].load(o);
+			}
+		}
+	}
+}
+
+inline void reset()
+{
+	const std::memory_order o = std::memory_order_relaxed;
+	Shard *tbl = getShardTbl();
+	for (size_t i = 0; i < shardN; i++) {
+		Shard& s = tbl[i];
+		for (size_t k = 0; k < kindN; k++) {
+			s.count[k].store(0, o);
+			s.itemN[k].store(0, o);
+			s.totalNs[k].store(0, o);
+			for (size_t j = 0; j < bucketN; j++) {
+				s.hist[k][j].store(0, o);
+			}
+		}
+	}
+}
+
+// add the elapsed time from the constructor to the destructor to kind
+class Scope {
+	typedef std::chrono::steady_clock Clock;
+	int kind_;
+	uint64_t n_;
+	Clock::time_point begin_;
+	Scope(const Scope&);
+	void operator=(const Scope&);
+public:
+	Scope(int kind, uint64_t n) : kind_(kind), n_(n), begin_(Clock::now()) {}
+	~Scope()
+	{
+		const uint64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - begin_).count();
+		add(kind_, n_, ns);
+	}
+};
+
+#define BLS_STAT_SCOPE(kind, n) bls_stats::Scope blsStatScope_(kind, n)
+
+#else
+
+#define BLS_STAT_SCOPE(kind, n)
+
+#endif
+
+} // bls_stats
@@ -0,0 +1,147 @@
+#pragma once
+/*
+	the phase events of the batch verification for blsSetTraceCallback
+	a scope calls the callback at the construction and the destruction
+	the callback is read once per scope, so the begin and the end of a phase are always paired
+*/
+#ifdef BLS_MULTI_VERIFY_THREAD
+#include <atomic>
+#endif
+
+namespace bls_trace {
+
+struct Hook {
+	blsTraceCallback f;
+	void *self;
+};
+
+/*
+	the registration of blsSetTraceCallback in static storage
+	gen is odd while a writer changes f and self, and a reader retries if gen changes while it copies them
+*/
+struct HookState {
+#ifdef BLS_MULTI_VERIFY_THREAD
+	std::atomic<unsigned int> gen;
+	std::atomic<blsTraceCallback> f;
+	std::atomic<void*> self;
+#else
+	blsTraceCallback f;
+	void *self;
+#endif
+};
+
+inline HookState& getHookState()
+{
+	static HookState s;
+	return s;
+}
+
+// the current hook ; h.f is NULL if tracing is disabled
+inline Hook loadHook()
+{
+	HookState& s = getHookState();
+	Hook h;
+#ifdef BLS_MULTI_VERIFY_THREAD
+	for (;;) {
+		const unsigned int g = s.gen.load(std::memory_order_acquire);
+		if (g & 1) continue;
+		h.f = s.f.load(std::memory_order_relaxed);
+		h.self = s.self.load(std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (s.gen.load(std::memory_order_relaxed) == g) return h;
+	}
+#else
+	h.f = s.f;
+	h.self = s.self;
+	return h;
+#endif
+}
+
+/*
+	publish f and self (f = NULL disables tracing)
+	if expected is not NULL, do it only if the current hook is *expected
+	return false if not published
+*/
+inline bool setHook(blsTraceCallback f, void *self, const Hook *expected = 0)
+{
+	HookState& s = getHookState();
+	bool ok;
+#ifdef BLS_MULTI_VERIFY_THREAD
+	unsigned int g = s.gen.load(std::memory_order_relaxed);
+	for (;;) {
+		if (g & 1) {
+			g = s.gen.load(std::memory_order_relaxed);
+			continue;
+		}
+		if (s.gen.compare_exchange_weak(g, g + 1, std::memory_order_acquire, std::memory_order_relaxed)) break;
+	}
+	std::atomic_thread_fence(std::memory_order_release);
+	ok = expected == 0 || (s.f.load(std::memory_order_relaxed) == expected->f && s.self.load(std::memory_order_relaxed) == expected->self);
+	if (ok) {
+		s.f.store(f, std::memory_order_relaxed);
+		s.self.store(self, std::memory_order_relaxed);
+	}
+	s.gen.store(g + 2, std::memory_order_release);
+#else
+	ok = expected == 0 || (s.f == expected->f && s.self == expected->self);
+	if (ok) {
+		s.f = f;
+		s.self = self;
+	}
+#endif
+	return ok;
+}
+
+inline const char *getName(int phase)
+{
+	static const char *tbl[BLS_PHASE_N] = {
+		"batch",
+		"worker",
+		"hash",
+		"mul",
+		"miller_loop",
+		"final_exp",
+		"join",
+	};
+	if (phase < 0 || phase >= BLS_PHASE_N) return 0;
+	return tbl[phase];
+}
+
+// 0, 1, 2, ... in the order of the first call of each thread
+inline int getThreadId()
+{
+#ifdef BLS_MULTI_VERIFY_THREAD
+	static std::atomic<int> next(0);
+	static thread_local int id = next.fetch_add(1, std::memory_order_relaxed);
+	return id;
+#else
+	return 0;
+#endif
+}
+
+class Scope {
+	blsTraceCallback f_;
+	void *self_;
+	int phase_;
+	mclSize n_;
+	Scope(const Scope&);
+	void operator=(const Scope&);
+public:
+	Scope(int phase, mclSize n)
+		: f_(0), self_(0), phase_(phase), n_(n)
+	{
+		const Hook h = loadHook();
+		if (h.f == 0) return;
+		f_ = h.f;
+		self_ = h.self;
+		f_(self_, phase_, 1, getThreadId(), n_);
+	}
+	~Scope()
+	{
+		if (f_) f_(self_, phase_, 0, getThreadId(), n_);
+	}
+};
+
+} // bls_trace
+
+#define BLS_TRACE_SCOPE(phase, n) bls_trace::Scope blsTraceScope_(phase, n)
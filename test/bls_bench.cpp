@@ -0,0 +1,400 @@
+/*
+	benchmark of the C API for BLS12-381
+	bls_bench.exe [-n 1,10,100] [-t 1,4] [-c count] [-f json|csv] [-o file] [-b baseline.csv] [-r ratio]
+	each entry is (name, n, threadN) ; n is the number of keys, signatures or shares of one call
+	ns/op and cycles/op are the cost of one call (e.g. n verifications of blsMultiVerify)
+	cycles/op is 0 if the time stamp counter is not available
+	-b compares ns/op with a file made by -f csv and returns 1 if some entry is slower than ratio times the baseline
+*/
+#include <bls/bls384_256.h>
+#include <cybozu/option.hpp>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <chrono>
+#if defined(_MSC_VER)
+	#include <intrin.h>
+	#define BLS_BENCH_USE_RDTSC
+#elif defined(__x86_64__) || defined(__i386__)
+	#include <x86intrin.h>
+	#define BLS_BENCH_USE_RDTSC
+#endif
+
+inline uint64_t getCycle()
+{
+#ifdef BLS_BENCH_USE_RDTSC
+	return __rdtsc();
+#else
+	return 0;
+#endif
+}
+
+inline double getNsec()
+{
+	return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+struct Result {
+	std::string name;
+	size_t n;
+	int threadN;
+	double ns; // mean
+	double cycles;
+	double p50, p90, p99;
+	std::string key() const
+	{
+		std::ostringstream os;
+		os << name << ',' << n << ',' << threadN;
+		return os.str();
+	}
+};
+
+/*
+	measure f by count samples
+	one sample runs f for inner times which takes 100 usec at least
+*/
+template<class F>
+Result measure(const std::string& name, size_t n, int threadN, int count, F f)
+{
+	f(); // warm up
+	double t = getNsec();
+	f();
+	t = getNsec() - t;
+	const double minSampleNs = 1e5;
+	const int inner = t >= minSampleNs ? 1 : int(minSampleNs / (t + 1)) + 1;
+	std::vector<double> sample(count);
+	double totalNs = 0;
+	uint64_t totalCycle = 0;
+	for (int i = 0; i < count; i++) {
+		const uint64_t c0 = getCycle();
+		const double t0 = getNsec();
+		for (int j = 0; j < inner; j++) f();
+		const double t1 = getNsec();
+		totalCycle += getCycle() - c0;
+		sample[i] = (t1 - t0) / inner;
+		totalNs += t1 - t0;
+	}
+	std::sort(sample.begin(), sample.end());
+	Result r;
+	r.name = name;
+	r.n = n;
+	r.threadN = threadN;
+	r.ns = totalNs / (double(count) * inner);
+	r.cycles = double(totalCycle) / (double(count) * inner);
+	r.p50 = sample[count * 50 / 100];
+	r.p90 = sample[count * 90 / 100];
+	r.p99 = sample[count * 99 / 100];
+	return r;
+}
+
+struct Bench {
+	int count;
+	std::vector<Result> results;
+	template<class F>
+	void run(const char *name, size_t n, int threadN, F f)
+	{
+		results.push_back(measure(name, n, threadN, count, f));
+		const Result& r = results.back();
+		fprintf(stderr, "%-32s n=%-6d threadN=%-2d %12.0f ns/op\n", name, (int)n, threadN, r.ns);
+	}
+};
+
+// data of n keys, signatures and shares
+struct Data {
+	std::vector<blsSecretKey> secVec;
+	std::vector<blsPublicKey> pubVec;
+	std::vector<blsSignature> sigVec; // signatures of msgVec[i]
+	std::vector<blsSignature> sameSigVec; // signatures of msg
+	std::vector<blsId> idVec;
+	std::vector<blsSignature> shareSigVec; // signatures of msg by the shares for idVec
+	std::vector<blsPublicKey> sharePubVec;
+	std::vector<uint64_t> randVec;
+	std::vector<uint8_t> okVec;
+	std::vector<char> msgVec;
+	blsSignature aggSig; // aggregated signature of msgVec
+	blsSignature sameAggSig; // aggregated signature of msg
+	static const size_t msgSize = 32;
+	void init(size_t n, const char *msg)
+	{
+		secVec.resize(n);
+		pubVec.resize(n);
+		sigVec.resize(n);
+		sameSigVec.resize(n);
+		idVec.resize(n);
+		shareSigVec.resize(n);
+		sharePubVec.resize(n);
+		randVec.resize(n);
+		okVec.resize(n);
+		msgVec.resize(n * msgSize);
+		for (size_t i = 0; i < n; i++) {
+			blsSecretKeySetByCSPRNG(&secVec[i]);
+			blsGetPublicKey(&pubVec[i], &secVec[i]);
+			for (size_t j = 0; j < msgSize; j++) {
+				msgVec[i * msgSize + j] = char(i >> ((j % 4) * 8)) + char(j);
+			}
+			blsSign(&sigVec[i], &secVec[i], &msgVec[i * msgSize], msgSize);
+			blsIdSetInt(&idVec[i], int(i + 1));
+			randVec[i] = (uint64_t(i) + 1) * 0x9e3779b97f4a7c15ull;
+		}
+		blsSignManyKeys(&sameSigVec[0], &secVec[0], n, msg, strlen(msg), 1);
+		blsAggregateSignature(&aggSig, &sigVec[0], n);
+		blsAggregateSignature(&sameAggSig, &sameSigVec[0], n);
+		// shares of a random polynomial of degree n - 1
+		std::vector<blsSecretKey> shareSecVec(n);
+		blsSecretKeyShareVec(&shareSecVec[0], &secVec[0], n, &idVec[0], n, 1);
+		for (size_t i = 0; i < n; i++) {
+			blsGetPublicKey(&sharePubVec[i], &shareSecVec[i]);
+		}
+		blsSignManyKeys(&shareSigVec[0], &shareSecVec[0], n, msg, strlen(msg), 1);
+	}
+};
+
+void benchSingle(Bench& bench)
+{
+	const char *msg = "bls_bench";
+	const size_t msgSize = strlen(msg);
+	blsSecretKey sec;
+	blsPublicKey pub;
+	blsSignature sig, Hm;
+	blsSecretKeySetByCSPRNG(&sec);
+	blsGetPublicKey(&pub, &sec);
+	blsSign(&sig, &sec, msg, msgSize);
+	char buf[256];
+	const mclSize pubSize = blsPublicKeySerialize(buf, sizeof(buf), &pub);
+	const mclSize sigSize = blsSignatureSerialize(buf + pubSize, sizeof(buf) - pubSize, &sig);
+	bench.run("blsHashToSignature", 1, 1, [&] { blsHashToSignature(&Hm, msg, msgSize); });
+	bench.run("blsGetPublicKey", 1, 1, [&] { blsGetPublicKey(&pub, &sec); });
+	const int w = blsGetGeneratorTableWindow();
+	blsSetGeneratorTableWindow(blsGetMaxGeneratorTableWindow());
+	bench.run("blsGetPublicKey(table)", 1, 1, [&] { blsGetPublicKey(&pub, &sec); });
+	blsSetGeneratorTableWindow(w);
+	bench.run("blsSign", 1, 1, [&] { blsSign(&sig, &sec, msg, msgSize); });
+	bench.run("blsVerify", 1, 1, [&] { blsVerify(&sig, &pub, msg, msgSize); });
+	bench.run("blsPublicKeySerialize", 1, 1, [&] { blsPublicKeySerialize(buf, pubSize, &pub); });
+	bench.run("blsPublicKeyDeserialize", 1, 1, [&] { blsPublicKeyDeserialize(&pub, buf, pubSize); });
+	bench.run("blsSignatureSerialize", 1, 1, [&] { blsSignatureSerialize(buf + pubSize, sigSize, &sig); });
+	bench.run("blsSignatureDeserialize", 1, 1, [&] { blsSignatureDeserialize(&sig, buf + pubSize, sigSize); });
+	bench.run("blsInit", 1, 1, [&] { blsInit(MCL_BLS12_381, MCLBN_COMPILED_TIME_VAR); });
+}
+
+// the check of blsAreAllMsgDifferent by std::set for comparison
+bool areAllMsgDifferentBySet(const void *msgVec, size_t msgSize, size_t n)
+{
+	std::set<std::string> ms;
+	for (size_t i = 0; i < n; i++) {
+		if (!ms.insert(std::string((const char*)msgVec + msgSize * i, msgSize)).second) return false;
+	}
+	return true;
+}
+
+void benchVec(Bench& bench, size_t n, const std::vector<int>& threadNVec)
+{
+	const char *msg = "bls_bench";
+	const size_t msgSize = strlen(msg);
+	Data d;
+	d.init(n, msg);
+	blsSignature sig;
+	blsPublicKey pub;
+	std::vector<char> msgBuf(8 * n + 8);
+	std::vector<blsSecretKey> outSecVec(n);
+	std::vector<blsPublicKey> outPubVec(n);
+	std::vector<blsSignature> outSigVec(n);
+	std::vector<mclSize> msgOffsetVec(n + 1);
+	for (size_t i = 0; i <= n; i++) msgOffsetVec[i] = i * d.msgSize;
+	// shares of n dealers whose polynomials have degree k - 1
+	const size_t k = 4;
+	std::vector<blsPublicKey> mpkVec(n * k);
+	std::vector<blsSecretKey> dealtSecVec(n);
+	for (size_t i = 0; i < n; i++) {
+		blsSecretKey msk[k];
+		for (size_t j = 0; j < k; j++) {
+			msk[j] = d.secVec[(i + j) % n];
+			mpkVec[i * k + j] = d.pubVec[(i + j) % n];
+		}
+		blsSecretKeyShare(&dealtSecVec[i], msk, k, &d.idVec[0]);
+	}
+	bench.run("blsAggregateSignature", n, 1, [&] { blsAggregateSignature(&sig, &d.sigVec[0], n); });
+	bench.run("blsFastAggregateVerify", n, 1, [&] { blsFastAggregateVerify(&d.sameAggSig, &d.pubVec[0], n, msg, msgSize); });
+#ifdef BLS_ETH
+	bench.run("blsAggregateVerifyNoCheck", n, 1, [&] { blsAggregateVerifyNoCheck(&d.aggSig, &d.pubVec[0], &d.msgVec[0], d.msgSize, n); });
+#endif
+	bench.run("blsSignatureRecover", n, 1, [&] { blsSignatureRecover(&sig, &d.shareSigVec[0], &d.idVec[0], n); });
+	bench.run("blsPublicKeyRecover", n, 1, [&] { blsPublicKeyRecover(&pub, &d.sharePubVec[0], &d.idVec[0], n); });
+	// the shares of the threshold (n + 1) / 2 and the same ones whose first signature is invalid
+	const size_t t = (n + 1) / 2;
+	std::vector<blsSecretKey> tSecVec(n);
+	std::vector<blsPublicKey> tPubVec(n);
+	std::vector<blsSignature> tSigVec(n);
+	blsSecretKeyShareVec(&tSecVec[0], &d.secVec[0], t, &d.idVec[0], n, 1);
+	for (size_t i = 0; i < n; i++) {
+		blsGetPublicKey(&tPubVec[i], &tSecVec[i]);
+	}
+	blsSignManyKeys(&tSigVec[0], &tSecVec[0], n, msg, msgSize, 1);
+	std::vector<blsSignature> badSigVec = tSigVec;
+	badSigVec[0] = tSigVec[n - 1];
+	bench.run("blsSignatureRecoverRobust", n, 1, [&] { blsSignatureRecoverRobust(&sig, &d.okVec[0], &tSigVec[0], &tPubVec[0], &d.idVec[0], n, t, &d.pubVec[0], msg, msgSize, &d.randVec[0], 8); });
+	if (n > 1) {
+		bench.run("blsSignatureRecoverRobust(1 bad)", n, 1, [&] { blsSignatureRecoverRobust(&sig, &d.okVec[0], &badSigVec[0], &tPubVec[0], &d.idVec[0], n, t, &d.pubVec[0], msg, msgSize, &d.randVec[0], 8); });
+	}
+	std::vector<blsSecretKey> coeffVec(n);
+	std::vector<blsId> revIdVec(d.idVec.rbegin(), d.idVec.rend());
+	bench.run("blsGetLagrangeCoefficient(consecutive)", n, 1, [&] { blsGetLagrangeCoefficient(&coeffVec[0], &d.idVec[0], n); });
+	bench.run("blsGetLagrangeCoefficient", n, 1, [&] { blsGetLagrangeCoefficient(&coeffVec[0], &revIdVec[0], n); });
+	blsRecoveryPlan plan;
+	blsRecoveryPlanInit(&plan, &coeffVec[0], &d.idVec[0], n);
+	bench.run("blsSignatureRecoverWithPlan", n, 1, [&] { blsSignatureRecoverWithPlan(&sig, &d.shareSigVec[0], &plan); });
+	for (size_t i = 0; i < threadNVec.size(); i++) {
+		const int threadN = threadNVec[i];
+#ifdef BLS_ETH
+		bench.run("blsMultiVerify", n, threadN, [&] { blsMultiVerify(&d.sigVec[0], &d.pubVec[0], &d.msgVec[0], d.msgSize, &d.randVec[0], 8, n, threadN); });
+#endif
+		// single-threaded, so once for any threadNVec
+		if (i == 0) {
+			bench.run("areAllMsgDifferentBySet", n, 1, [&] { areAllMsgDifferentBySet(&d.msgVec[0], d.msgSize, n); });
+		}
+		bench.run("blsAreAllMsgDifferent", n, threadN, [&] { blsAreAllMsgDifferent(&d.msgVec[0], d.msgSize, n, &msgBuf[0], msgBuf.size(), threadN); });
+		bench.run("blsSignatureMulVecMT", n, threadN, [&] { blsSignatureMulVecMT(&sig, &d.sigVec[0], &d.secVec[0], n, threadN); });
+		bench.run("blsSignVec", n, threadN, [&] { blsSignVec(&outSigVec[0], &d.secVec[0], &d.msgVec[0], &msgOffsetVec[0], n, threadN); });
+		bench.run("blsKeyGenVec", n, threadN, [&] { blsKeyGenVec(&outSecVec[0], &outPubVec[0], n, msg, msgSize, 0, threadN); });
+		bench.run("blsVerifySecretKeyShareVec", n, threadN, [&] { blsVerifySecretKeyShareVec(&d.okVec[0], &dealtSecVec[0], &mpkVec[0], k, &d.idVec[0], n, &d.randVec[0], 8, threadN); });
+		bench.run("blsPublicKeyShareVec", n, threadN, [&] { blsPublicKeyShareVec(&outPubVec[0], &mpkVec[0], k, &d.idVec[0], n, threadN); });
+		bench.run("blsVerifySameMessageVec", n, threadN, [&] { blsVerifySameMessageVec(&d.okVec[0], &d.sameSigVec[0], &d.pubVec[0], n, msg, msgSize, &d.randVec[0], 8, threadN); });
+		bench.run("blsSignatureRecoverMT", n, threadN, [&] { blsSignatureRecoverMT(&sig, &d.shareSigVec[0], &d.idVec[0], n, threadN); });
+		bench.run("blsSignManyKeys", n, threadN, [&] { blsSignManyKeys(&d.sameSigVec[0], &d.secVec[0], n, msg, msgSize, threadN); });
+	}
+}
+
+void putCsv(FILE *fp, const std::vector<Result>& results)
+{
+	fprintf(fp, "name,n,threadN,ns_per_op,cycles_per_op,ops_per_sec,p50_ns,p90_ns,p99_ns\n");
+	for (size_t i = 0; i < results.size(); i++) {
+		const Result& r = results[i];
+		fprintf(fp, "%s,%.1f,%.1f,%.2f,%.1f,%.1f,%.1f\n", r.key().c_str(), r.ns, r.cycles, 1e9 / r.ns, r.p50, r.p90, r.p99);
+	}
+}
+
+void putJson(FILE *fp, const std::vector<Result>& results)
+{
+#ifdef BLS_ETH
+	const char *mode = "eth";
+#else
+	const char *mode = "non-eth";
+#endif
+	fprintf(fp, "{\n\"mode\": \"%s\",\n\"results\": [\n", mode);
+	for (size_t i = 0; i < results.size(); i++) {
+		const Result& r = results[i];
+		fprintf(fp, "{\"name\": \"%s\", \"n\": %d, \"threadN\": %d, \"ns_per_op\": %.1f, \"cycles_per_op\": %.1f, \"ops_per_sec\": %.2f, \"p50_ns\": %.1f, \"p90_ns\": %.1f, \"p99_ns\": %.1f}%s\n",
+			r.name.c_str(), (int)r.n, r.threadN, r.ns, r.cycles, 1e9 / r.ns, r.p50, r.p90, r.p99, i + 1 < results.size() ? "," : "");
+	}
+	fprintf(fp, "]\n}\n");
+}
+
+// return the map of key() to ns_per_op of the file made by putCsv
+bool loadBaseline(std::map<std::string, double>& tbl, const std::string& file)
+{
+	std::ifstream ifs(file.c_str());
+	if (!ifs) return false;
+	std::string line;
+	std::getline(ifs, line); // header
+	while (std::getline(ifs, line)) {
+		std::vector<std::string> v;
+		std::istringstream is(line);
+		std::string s;
+		while (std::getline(is, s, ',')) v.push_back(s);
+		if (v.size() < 4) continue;
+		tbl[v[0] + ',' + v[1] + ',' + v[2]] = atof(v[3].c_str());
+	}
+	return true;
+}
+
+// return the number of entries slower than ratio times the baseline
+int compareBaseline(const std::vector<Result>& results, const std::map<std::string, double>& tbl, double ratio)
+{
+	int regressionN = 0;
+	for (size_t i = 0; i < results.size(); i++) {
+		const Result& r = results[i];
+		std::map<std::string, double>::const_iterator it = tbl.find(r.key());
+		if (it == tbl.end() || it->second <= 0) continue;
+		const double rate = r.ns / it->second;
+		if (rate > ratio) {
+			fprintf(stderr, "REGRESSION %s base=%.0f now=%.0f (x%.2f)\n", r.key().c_str(), it->second, r.ns, rate);
+			regressionN++;
+		}
+	}
+	return regressionN;
+}
+
+// "1,10,100" -> {1, 10, 100}
+template<class T>
+std::vector<T> parseList(const std::string& s)
+{
+	std::vector<T> v;
+	std::istringstream is(s);
+	std::string t;
+	while (std::getline(is, t, ',')) {
+		if (!t.empty()) v.push_back(T(atoi(t.c_str())));
+	}
+	return v;
+}
+
+int main(int argc, char *argv[])
+{
+	std::string nStr, threadNStr, format, outFile, baseFile;
+	int count;
+	double ratio;
+	cybozu::Option opt;
+	opt.appendOpt(&nStr, "1,10,100,1000", "n", ": comma-separated sizes of the vector APIs");
+	opt.appendOpt(&threadNStr, "1,4", "t", ": comma-separated numbers of threads");
+	opt.appendOpt(&count, 100, "c", ": the number of samples of each entry");
+	opt.appendOpt(&format, "json", "f", ": json or csv");
+	opt.appendOpt(&outFile, "", "o", ": output file (default stdout)");
+	opt.appendOpt(&baseFile, "", "b", ": baseline made by -f csv");
+	opt.appendOpt(&ratio, 1.1, "r", ": regression if ns/op > ratio * baseline");
+	opt.appendHelp("h");
+	if (!opt.parse(argc, argv) || count <= 0 || (format != "json" && format != "csv")) {
+		opt.usage();
+		return 1;
+	}
+	if (blsInit(MCL_BLS12_381, MCLBN_COMPILED_TIME_VAR) != 0) {
+		fprintf(stderr, "blsInit\n");
+		return 1;
+	}
+	const std::vector<size_t> nVec = parseList<size_t>(nStr);
+	const std::vector<int> threadNVec = parseList<int>(threadNStr);
+	Bench bench;
+	bench.count = count;
+	benchSingle(bench);
+	for (size_t i = 0; i < nVec.size(); i++) {
+		if (nVec[i] == 0) continue;
+		benchVec(bench, nVec[i], threadNVec);
+	}
+	FILE *fp = stdout;
+	if (!outFile.empty()) {
+		fp = fopen(outFile.c_str(), "w");
+		if (fp == 0) {
+			fprintf(stderr, "can't open %s\n", outFile.c_str());
+			return 1;
+		}
+	}
+	if (format == "json") {
+		putJson(fp, bench.results);
+	} else {
+		putCsv(fp, bench.results);
+	}
+	if (fp != stdout) fclose(fp);
+	if (!baseFile.empty()) {
+		std::map<std::string, double> tbl;
+		if (!loadBaseline(tbl, baseFile)) {
+			fprintf(stderr, "can't load %s\n", baseFile.c_str());
+			return 1;
+		}
+		if (compareBaseline(bench.results, tbl, ratio) > 0) return 1;
+	}
+	return 0;
+}
@@ -1,9 +1,15 @@
 #include <cybozu/test.hpp>
 #include <cybozu/inttype.hpp>
 #include <bls/bls.h>
+#include <bls/chrome_trace.hpp>
+#include <bls/msg.hpp>
 #include <string.h>
 #include <cybozu/benchmark.hpp>
 #include <mcl/gmp_util.hpp>
+#include <cybozu/xorshift.hpp>
+#include <set>
+#include <string>
+#include <vector>
 
 size_t pubSize(size_t FrSize)
 {
@@ -392,6 +398,15 @@ void blsMultiAggregateTest()
 		memset(&aggSig, -1, sizeof(aggSig));
 		blsMultiAggregatePublicKey(&aggPub, pubVec, n);
 		blsMultiAggregateSignature(&aggSig, sigVec, pubVec, n);
+		{
+			blsSecretKey coeffVec[N];
+			blsMultiAggregateContext ctx;
+			blsSignature aggSig2;
+			blsMultiAggregateContextInit(&ctx, coeffVec, pubVec, n);
+			blsMultiAggregateSignatureWithContext(&aggSig2, sigVec, &ctx);
+			CYBOZU_TEST_ASSERT(blsPublicKeyIsEqual(&ctx.aggPub, &aggPub));
+			CYBOZU_TEST_ASSERT(blsSignatureIsEqual(&aggSig2, &aggSig));
+		}
 		if (n == 0) {
 			CYBOZU_TEST_ASSERT(blsPublicKeyIsZero(&aggPub));
 			CYBOZU_TEST_ASSERT(blsSignatureIsZero(&aggSig));
@@ -402,6 +417,887 @@ void blsMultiAggregateTest()
 	}
 }
 
+void blsSignManyKeysTest()
+{
+	const size_t N = 100;
+	const char *msg = "abc";
+	const size_t msgSize = strlen(msg);
+	blsSecretKey secVec[N];
+	blsSignature sigVec[N];
+	for (size_t i = 0; i < N; i++) {
+		blsSecretKeySetByCSPRNG(&secVec[i]);
+	}
+	{
+		blsSignature Hm, sig1, sig2;
+		blsHashToSignature(&Hm, msg, msgSize);
+		blsSignHashedPoint(&sig1, &secVec[0], &Hm);
+		blsSign(&sig2, &secVec[0], msg, msgSize);
+		CYBOZU_TEST_ASSERT(blsSignatureIsEqual(&sig1, &sig2));
+	}
+	const size_t nTbl[] = { 0, 1, 33, N };
+	const int threadNTbl[] = { 1, 4 };
+	for (size_t i = 0; i < CYBOZU_NUM_OF_ARRAY(nTbl); i++) {
+		const size_t n = nTbl[i];
+		for (size_t j = 0; j < CYBOZU_NUM_OF_ARRAY(threadNTbl); j++) {
+			memset(sigVec, 0, sizeof(sigVec));
+			blsSignManyKeys(sigVec, secVec, n, msg, msgSize, threadNTbl[j]);
+			for (size_t k = 0; k < n; k++) {
+				blsSignature sig;
+				blsSign(&sig, &secVec[k], msg, msgSize);
+				CYBOZU_TEST_ASSERT(blsSignatureIsEqual(&sigVec[k], &sig));
+			}
+		}
+	}
+}
+
+void blsSignVecTest()
+{
+	const size_t N = 100;
+	char msgVec[N * 3];
+	mclSize msgOffsetVec[N + 1];
+	blsSignature sigVec[N];
+	blsSecretKey sec;
+	blsSecretKeySetByCSPRNG(&sec);
+	msgOffsetVec[0] = 0;
+	for (size_t i = 0; i < N; i++) {
+		// the messages have 1, 2 or 3 bytes
+		const size_t size = i % 3 + 1;
+		for (size_t j = 0; j < size; j++) msgVec[msgOffsetVec[i] + j] = char(i * 3 + j);
+		msgOffsetVec[i + 1] = msgOffsetVec[i] + size;
+	}
+	const size_t nTbl[] = { 0, 1, 33, N };
+	const int threadNTbl[] = { 1, 4 };
+	for (size_t i = 0; i < CYBOZU_NUM_OF_ARRAY(nTbl); i++) {
+		const size_t n = nTbl[i];
+		for (size_t j = 0; j < CYBOZU_NUM_OF_ARRAY(threadNTbl); j++) {
+			memset(sigVec, 0, sizeof(sigVec));
+			blsSignVec(sigVec, &sec, msgVec, msgOffsetVec, n, threadNTbl[j]);
+			for (size_t k = 0; k < n; k++) {
+				blsSignature sig;
+				blsSign(&sig, &sec, &msgVec[msgOffsetVec[k]], msgOffsetVec[k + 1] - msgOffsetVec[k]);
+				CYBOZU_TEST_ASSERT(blsSignatureIsEqual(&sigVec[k], &sig));
+			}
+		}
+	}
+}
+
+void blsGeneratorTableTest()
+{
+	const size_t N = 5;
+	blsSecretKey secVec[N];
+	blsPublicKey pubVec[N];
+	blsSignature popVec[N];
+	CYBOZU_TEST_EQUAL(blsSetGeneratorTableWindow(0), 0);
+	CYBOZU_TEST_EQUAL(blsGetGeneratorTableWindow(), 0);
+	for (size_t i = 0; i < N; i++) {
+		if (i == 0) {
+			blsSecretKeySetHexStr(&secVec[i], "0", 1);
+		} else if (i == 1) {
+			blsSecretKeySetHexStr(&secVec[i], "1", 1);
+		} else {
+			blsSecretKeySetByCSPRNG(&secVec[i]);
+		}
+		blsGetPublicKey(&pubVec[i], &secVec[i]);
+		blsGetPop(&popVec[i], &secVec[i]);
+	}
+	const int maxW = blsGetMaxGeneratorTableWindow();
+	CYBOZU_TEST_ASSERT(maxW >= 2);
+	for (int w = 2; w <= maxW; w++) {
+		CYBOZU_TEST_EQUAL(blsSetGeneratorTableWindow(w), 0);
+		CYBOZU_TEST_EQUAL(blsGetGeneratorTableWindow(), w);
+		for (size_t i = 0; i < N; i++) {
+			blsPublicKey pub;
+			blsSignature pop;
+			blsGetPublicKey(&pub, &secVec[i]);
+			blsGetPop(&pop, &secVec[i]);
+			CYBOZU_TEST_ASSERT(blsPublicKeyIsEqual(&pub, &pubVec[i]));
+			CYBOZU_TEST_ASSERT(blsSignatureIsEqual(&pop, &popVec[i]));
+		}
+	}
+	// an invalid window does not change the table
+	CYBOZU_TEST_EQUAL(blsSetGeneratorTableWindow(1), -1);
+	CYBOZU_TEST_EQUAL(blsSetGeneratorTableWindow(-1), -1);
+	CYBOZU_TEST_EQUAL(blsSetGeneratorTableWindow(maxW + 1), -1);
+	CYBOZU_TEST_EQUAL(blsGetGeneratorTableWindow(), maxW);
+	// the table is remade for a new generator
+	blsPublicKey gen, gen2;
+	blsGetGeneratorOfPublicKey(&gen);
+	gen2 = gen;
+	blsPublicKeyAdd(&gen2, &gen);
+	CYBOZU_TEST_EQUAL(blsSetGeneratorOfPublicKey(&gen2), 0);
+	CYBOZU_TEST_EQUAL(blsGetGeneratorTableWindow(), maxW);
+	for (size_t i = 0; i < N; i++) {
+		blsPublicKey pub, pub2;
+		blsGetPublicKey(&pub, &secVec[i]);
+		pub2 = pubVec[i];
+		blsPublicKeyAdd(&pub2, &pubVec[i]);
+		CYBOZU_TEST_ASSERT(blsPublicKeyIsEqual(&pub, &pub2));
+	}
+	CYBOZU_TEST_EQUAL(blsSetGeneratorOfPublicKey(&gen), 0);
+	CYBOZU_TEST_EQUAL(blsSetGeneratorTableWindow(0), 0);
+	CYBOZU_TEST_EQUAL(blsGetGeneratorTableWindow(), 0);
+}
+
+void blsContextTest()
+{
+	std::vector<uint64_t> buf((blsGetContextByteSize() + 7) / 8);
+	blsContext *ctx = (blsContext*)&buf[0];
+	blsContextInit(ctx);
+	const char *msg = "message of context";
+	const size_t msgSize = strlen(msg);
+	blsSecretKey sec;
+	blsPublicKey pub, pub2, gen, gen2;
+	blsSignature sig, sig2;
+	blsSecretKeySetByCSPRNG(&sec);
+	// the same as the global settings
+	blsGetPublicKey(&pub, &sec);
+	blsGetPublicKeyWithContext(&pub2, &sec, ctx);
+	CYBOZU_TEST_ASSERT(blsPublicKeyIsEqual(&pub, &pub2));
+	blsSign(&sig, &sec, msg, msgSize);
+	blsSignWithContext(&sig2, &sec, msg, msgSize, ctx);
+	CYBOZU_TEST_ASSERT(blsSignatureIsEqual(&sig, &sig2));
+	CYBOZU_TEST_ASSERT(blsVerifyWithContext(&sig, &pub, msg, msgSize, ctx));
+	CYBOZU_TEST_ASSERT(!blsVerifyWithContext(&sig, &pub, msg, msgSize - 1, ctx));
+	CYBOZU_TEST_ASSERT(blsFastAggregateVerifyWithContext(&sig, &pub, 1, msg, msgSize, ctx));
+#ifdef BLS_ETH
+	CYBOZU_TEST_ASSERT(blsAggregateVerifyWithContext(&sig, &pub, msg, msgSize, 1, ctx));
+	CYBOZU_TEST_ASSERT(blsAggregateVerifyNoCheckWithContext(&sig, &pub, msg, msgSize, 1, ctx));
+#endif
+	// the generator of ctx does not change the global one
+	blsGetGeneratorOfPublicKey(&gen);
+	gen2 = gen;
+	blsPublicKeyAdd(&gen2, &gen);
+	CYBOZU_TEST_EQUAL(blsContextSetGeneratorOfPublicKey(ctx, &gen2), 0);
+	blsContextGetGeneratorOfPublicKey(&pub2, ctx);
+	CYBOZU_TEST_ASSERT(blsPublicKeyIsEqual(&pub2, &gen2));
+	blsGetGeneratorOfPublicKey(&pub2);
+	CYBOZU_TEST_ASSERT(blsPublicKeyIsEqual(&pub2, &gen));
+	blsGetPublicKeyWithContext(&pub2, &sec, ctx);
+	CYBOZU_TEST_ASSERT(!blsPublicKeyIsEqual(&pub, &pub2));
+	blsPublicKeyAdd(&pub, &pub);
+	CYBOZU_TEST_ASSERT(blsPublicKeyIsEqual(&pub, &pub2));
+	CYBOZU_TEST_ASSERT(blsVerifyWithContext(&sig, &pub2, msg, msgSize, ctx));
+	CYBOZU_TEST_ASSERT(!blsVerify(&sig, &pub2, msg, msgSize));
+	// DST of ctx (only hash-to-curve on BLS12-381 in ETH mode)
+	const char *dst = "BLS_SIG_BLS12381G2_XMD:SHA-256_SSWU_RO_NUL_";
+	if (blsContextSetDst(ctx, dst, strlen(dst)) == 0) {
+		blsSignWithContext(&sig2, &sec, msg, msgSize, ctx);
+		CYBOZU_TEST_ASSERT(!blsSignatureIsEqual(&sig, &sig2));
+		CYBOZU_TEST_ASSERT(blsVerifyWithContext(&sig2, &pub2, msg, msgSize, ctx));
+		blsSign(&sig2, &sec, msg, msgSize);
+		CYBOZU_TEST_ASSERT(blsSignatureIsEqual(&sig, &sig2));
+		// the same as the hash of mcl with dst
+		blsSignature sig3;
+		blsSignWithContext(&sig2, &sec, msg, msgSize, ctx);
+		CYBOZU_TEST_EQUAL(blsSetDst(dst, strlen(dst)), 0);
+		blsSign(&sig3, &sec, msg, msgSize);
+		CYBOZU_TEST_ASSERT(blsSignatureIsEqual(&sig2, &sig3));
+		const char *defaultDst = "BLS_SIG_BLS12381G2_XMD:SHA-256_SSWU_RO_POP_";
+		CYBOZU_TEST_EQUAL(blsSetDst(defaultDst, strlen(defaultDst)), 0);
+	}
+}
+
+void blsVerifySecretKeyShareVecTest()
+{
+	const size_t n = 20;
+	const size_t k = 4;
+	blsSecretKey secVec[n];
+	blsPublicKey mpkVec[n * k];
+	uint8_t randVec[n * 8];
+	uint8_t okVec[n];
+	blsId id;
+	blsIdSetInt(&id, 123);
+	cybozu::XorShift rg;
+	for (size_t i = 0; i < n; i++) {
+		blsSecretKey msk[k];
+		for (size_t j = 0; j < k; j++) {
+			blsSecretKeySetByCSPRNG(&msk[j]);
+			blsGetPublicKey(&mpkVec[k * i + j], &msk[j]);
+		}
+		CYBOZU_TEST_EQUAL(blsSecretKeyShare(&secVec[i], msk, k, &id), 0);
+		for (size_t j = 0; j < 8; j++) randVec[i * 8 + j] = uint8_t(rg.get32());
+	}
+	for (int threadN = 1; threadN <= 4; threadN += 3) {
+		memset(okVec, 0, n);
+		CYBOZU_TEST_EQUAL(blsVerifySecretKeyShareVec(okVec, secVec, mpkVec, k, &id, n, randVec, 8, threadN), n);
+		for (size_t i = 0; i < n; i++) CYBOZU_TEST_EQUAL(okVec[i], 1);
+	}
+	// the same as blsPublicKeyShare
+	for (size_t i = 0; i < n; i++) {
+		blsPublicKey pub1, pub2;
+		blsGetPublicKey(&pub1, &secVec[i]);
+		CYBOZU_TEST_EQUAL(blsPublicKeyShare(&pub2, &mpkVec[k * i], k, &id), 0);
+		CYBOZU_TEST_ASSERT(blsPublicKeyIsEqual(&pub1, &pub2));
+	}
+	// find the cheating dealers
+	const size_t badTbl[] = { 0, 7, 8, n - 1 };
+	const size_t badN = CYBOZU_NUM_OF_ARRAY(badTbl);
+	blsSecretKey one;
+	blsSecretKeySetHexStr(&one, "1", 1);
+	for (size_t i = 0; i < badN; i++) {
+		blsSecretKeyAdd(&secVec[badTbl[i]], &one);
+	}
+	for (int threadN = 1; threadN <= 4; threadN += 3) {
+		CYBOZU_TEST_EQUAL(blsVerifySecretKeyShareVec(okVec, secVec, mpkVec, k, &id, n, randVec, 8, threadN), n - badN);
+		for (size_t i = 0; i < n; i++) {
+			bool bad = false;
+			for (size_t j = 0; j < badN; j++) {
+				if (badTbl[j] == i) bad = true;
+			}
+			CYBOZU_TEST_EQUAL(okVec[i], bad ? 0 : 1);
+		}
+	}
+	// a wrong commitment
+	for (size_t i = 0; i < badN; i++) {
+		blsSecretKeySub(&secVec[badTbl[i]], &one);
+	}
+	blsPublicKeyAdd(&mpkVec[k * 3 + 2], &mpkVec[0]);
+	CYBOZU_TEST_EQUAL(blsVerifySecretKeyShareVec(okVec, secVec, mpkVec, k, &id, n, randVec, 8, 1), n - 1);
+	CYBOZU_TEST_EQUAL(okVec[3], 0);
+	CYBOZU_TEST_EQUAL(blsVerifySecretKeyShareVec(okVec, secVec, mpkVec, 0, &id, n, randVec, 8, 1), 0);
+	CYBOZU_TEST_EQUAL(okVec[0], 0);
+}
+
+void blsShareVecTest()
+{
+	const size_t n = 40;
+	const size_t k = 70;
+	blsSecretKey msk[k];
+	blsPublicKey mpk[k];
+	blsId idVec[n];
+	blsSecretKey secVec[n];
+	blsPublicKey pubVec[n];
+	for (size_t j = 0; j < k; j++) {
+		blsSecretKeySetByCSPRNG(&msk[j]);
+		blsGetPublicKey(&mpk[j], &msk[j]);
+	}
+	for (size_t i = 0; i < n; i++) {
+		if (i < n / 2) {
+			blsIdSetInt(&idVec[i], int(i + 1));
+		} else {
+			blsSecretKey t;
+			blsSecretKeySetByCSPRNG(&t);
+			memcpy(&idVec[i], &t, sizeof(idVec[i]));
+		}
+	}
+	const size_t kTbl[] = { 1, 2, 5, 64, k };
+	for (size_t ki = 0; ki < CYBOZU_NUM_OF_ARRAY(kTbl); ki++) {
+		const size_t kk = kTbl[ki];
+		for (int threadN = 1; threadN <= 4; threadN += 3) {
+			CYBOZU_TEST_EQUAL(blsSecretKeyShareVec(secVec, msk, kk, idVec, n, threadN), 0);
+			CYBOZU_TEST_EQUAL(blsPublicKeyShareVec(pubVec, mpk, kk, idVec, n, threadN), 0);
+			for (size_t i = 0; i < n; i++) {
+				blsSecretKey sec;
+				blsPublicKey pub;
+				CYBOZU_TEST_EQUAL(blsSecretKeyShare(&sec, msk, kk, &idVec[i]), 0);
+				CYBOZU_TEST_EQUAL(blsPublicKeyShare(&pub, mpk, kk, &idVec[i]), 0);
+				CYBOZU_TEST_ASSERT(blsSecretKeyIsEqual(&sec, &secVec[i]));
+				CYBOZU_TEST_ASSERT(blsPublicKeyIsEqual(&pub, &pubVec[i]));
+			}
+		}
+	}
+	CYBOZU_TEST_EQUAL(blsSecretKeyShareVec(secVec, msk, 0, idVec, n, 1), -1);
+	CYBOZU_TEST_EQUAL(blsPublicKeyShareVec(pubVec, mpk, 0, idVec, n, 1), -1);
+}
+
+void blsRecoveryPlanTest()
+{
+	const size_t n = 10;
+	const size_t k = 6;
+	blsSecretKey msk[k];
+	blsPublicKey mpk[k];
+	blsId idVec[n];
+	blsSecretKey secVec[n];
+	blsPublicKey pubVec[n];
+	blsSignature sigVec[n];
+	blsSecretKey coeffVec[n];
+	const char *msg = "message of recovery";
+	const size_t msgSize = strlen(msg);
+	for (size_t j = 0; j < k; j++) {
+		blsSecretKeySetByCSPRNG(&msk[j]);
+		blsGetPublicKey(&mpk[j], &msk[j]);
+	}
+	for (size_t i = 0; i < n; i++) {
+		blsIdSetInt(&idVec[i], int(i * 3 + 5));
+		CYBOZU_TEST_EQUAL(blsSecretKeyShare(&secVec[i], msk, k, &idVec[i]), 0);
+		blsGetPublicKey(&pubVec[i], &secVec[i]);
+		blsSign(&sigVec[i], &secVec[i], msg, msgSize);
+	}
+	blsSignature sig0;
+	blsSign(&sig0, &msk[0], msg, msgSize);
+	// the same subset of the signers is used many times
+	for (size_t m = k; m <= n; m += 2) {
+		const size_t begin = n - m;
+		blsRecoveryPlan plan;
+		CYBOZU_TEST_EQUAL(blsRecoveryPlanInit(&plan, coeffVec, &idVec[begin], m), 0);
+		blsSecretKey sec1, sec2;
+		blsPublicKey pub1, pub2;
+		blsSignature sig1, sig2;
+		CYBOZU_TEST_EQUAL(blsSecretKeyRecover(&sec1, &secVec[begin], &idVec[begin], m), 0);
+		CYBOZU_TEST_EQUAL(blsPublicKeyRecover(&pub1, &pubVec[begin], &idVec[begin], m), 0);
+		CYBOZU_TEST_EQUAL(blsSignatureRecover(&sig1, &sigVec[begin], &idVec[begin], m), 0);
+		CYBOZU_TEST_EQUAL(blsSecretKeyRecoverWithPlan(&sec2, &secVec[begin], &plan), 0);
+		CYBOZU_TEST_EQUAL(blsPublicKeyRecoverWithPlan(&pub2, &pubVec[begin], &plan), 0);
+		CYBOZU_TEST_EQUAL(blsSignatureRecoverWithPlan(&sig2, &sigVec[begin], &plan), 0);
+		CYBOZU_TEST_ASSERT(blsSecretKeyIsEqual(&sec1, &sec2));
+		CYBOZU_TEST_ASSERT(blsSecretKeyIsEqual(&sec1, &msk[0]));
+		CYBOZU_TEST_ASSERT(blsPublicKeyIsEqual(&pub1, &pub2));
+		CYBOZU_TEST_ASSERT(blsPublicKeyIsEqual(&pub1, &mpk[0]));
+		CYBOZU_TEST_ASSERT(blsSignatureIsEqual(&sig1, &sig2));
+		CYBOZU_TEST_ASSERT(blsSignatureIsEqual(&sig1, &sig0));
+	}
+	// invalid id sets
+	{
+		blsRecoveryPlan plan;
+		blsSignature sig;
+		CYBOZU_TEST_EQUAL(blsRecoveryPlanInit(&plan, coeffVec, idVec, 0), -1);
+		CYBOZU_TEST_EQUAL(blsSignatureRecoverWithPlan(&sig, sigVec, &plan), -1);
+		blsId idVec2[3] = { idVec[0], idVec[1], idVec[0] };
+		CYBOZU_TEST_EQUAL(blsRecoveryPlanInit(&plan, coeffVec, idVec2, 3), -1);
+		blsIdSetInt(&idVec2[2], 0);
+		CYBOZU_TEST_EQUAL(blsRecoveryPlanInit(&plan, coeffVec, idVec2, 3), -1);
+	}
+}
+
+void blsGetLagrangeCoefficientTest()
+{
+	const size_t n = 300;
+	std::vector<blsId> idVec(n), revIdVec(n);
+	std::vector<blsSecretKey> c1(n), c2(n), msk(n), secVec(n);
+	for (size_t i = 0; i < n; i++) {
+		blsIdSetInt(&idVec[i], int(i + 1));
+		revIdVec[n - 1 - i] = idVec[i];
+		blsSecretKeySetByCSPRNG(&msk[i]);
+	}
+	// consecutive ids
+	CYBOZU_TEST_EQUAL(blsGetLagrangeCoefficient(&c1[0], &idVec[0], n), 0);
+	// the same ids which are not consecutive
+	CYBOZU_TEST_EQUAL(blsGetLagrangeCoefficient(&c2[0], &revIdVec[0], n), 0);
+	for (size_t i = 0; i < n; i++) {
+		CYBOZU_TEST_ASSERT(blsSecretKeyIsEqual(&c1[i], &c2[n - 1 - i]));
+	}
+	CYBOZU_TEST_EQUAL(blsSecretKeyShareVec(&secVec[0], &msk[0], n, &idVec[0], n, 1), 0);
+	blsSecretKey sec;
+	CYBOZU_TEST_EQUAL(blsSecretKeyRecover(&sec, &secVec[0], &idVec[0], n), 0);
+	CYBOZU_TEST_ASSERT(blsSecretKeyIsEqual(&sec, &msk[0]));
+	for (size_t m = 1; m < 5; m++) {
+		// small sets of ids from 7
+		blsId id[5];
+		blsSecretKey c[5];
+		for (size_t i = 0; i < m; i++) blsIdSetInt(&id[i], int(m - i + 6));
+		CYBOZU_TEST_EQUAL(blsGetLagrangeCoefficient(c, id, m), 0);
+		CYBOZU_TEST_EQUAL(blsGetLagrangeCoefficient(&c1[0], &idVec[6], m), 0);
+		for (size_t i = 0; i < m; i++) {
+			CYBOZU_TEST_ASSERT(blsSecretKeyIsEqual(&c[m - 1 - i], &c1[i]));
+		}
+	}
+	// zero id
+	blsId id[3];
+	for (size_t i = 0; i < 3; i++) blsIdSetInt(&id[i], int(i) - 2);
+	CYBOZU_TEST_EQUAL(blsGetLagrangeCoefficient(&c1[0], id, 3), -1);
+	CYBOZU_TEST_EQUAL(blsGetLagrangeCoefficient(&c1[0], id, 0), -1);
+}
+
+void blsRecoverMTTest()
+{
+	// larger than the chunk of the Lagrange coefficients
+	const size_t N = 1000;
+	std::vector<blsSecretKey> msk(N);
+	std::vector<blsPublicKey> mpk(N);
+	std::vector<blsId> idVec(N);
+	std::vector<blsSecretKey> secVec(N);
+	std::vector<blsPublicKey> pubVec(N);
+	std::vector<blsSignature> sigVec(N);
+	const char *msg = "message of recovery";
+	const size_t msgSize = strlen(msg);
+	for (size_t j = 0; j < N; j++) {
+		blsSecretKeySetByCSPRNG(&msk[j]);
+		blsIdSetInt(&idVec[j], int(j * 7 + 1));
+	}
+	blsGetPublicKey(&mpk[0], &msk[0]);
+	blsSignature sig0;
+	blsSign(&sig0, &msk[0], msg, msgSize);
+	const size_t tbl[] = { 1, 10, 300, N };
+	for (size_t i = 0; i < CYBOZU_NUM_OF_ARRAY(tbl); i++) {
+		const size_t k = tbl[i];
+		CYBOZU_TEST_EQUAL(blsSecretKeyShareVec(&secVec[0], &msk[0], k, &idVec[0], k, 4), 0);
+		for (size_t j = 0; j < k; j++) {
+			blsGetPublicKey(&pubVec[j], &secVec[j]);
+		}
+		blsSignManyKeys(&sigVec[0], &secVec[0], k, msg, msgSize, 4);
+		blsSecretKey sec;
+		blsPublicKey pub;
+		blsSignature sig;
+		CYBOZU_TEST_EQUAL(blsSecretKeyRecover(&sec, &secVec[0], &idVec[0], k), 0);
+		CYBOZU_TEST_ASSERT(blsSecretKeyIsEqual(&sec, &msk[0]));
+		CYBOZU_TEST_EQUAL(blsPublicKeyRecover(&pub, &pubVec[0], &idVec[0], k), 0);
+		CYBOZU_TEST_ASSERT(blsPublicKeyIsEqual(&pub, &mpk[0]));
+		CYBOZU_TEST_EQUAL(blsSignatureRecover(&sig, &sigVec[0], &idVec[0], k), 0);
+		CYBOZU_TEST_ASSERT(blsSignatureIsEqual(&sig, &sig0));
+		for (int threadN = 2; threadN <= 8; threadN *= 2) {
+			CYBOZU_TEST_EQUAL(blsPublicKeyRecoverMT(&pub, &pubVec[0], &idVec[0], k, threadN), 0);
+			CYBOZU_TEST_ASSERT(blsPublicKeyIsEqual(&pub, &mpk[0]));
+			CYBOZU_TEST_EQUAL(blsSignatureRecoverMT(&sig, &sigVec[0], &idVec[0], k, threadN), 0);
+			CYBOZU_TEST_ASSERT(blsSignatureIsEqual(&sig, &sig0));
+		}
+	}
+	// the same ids in different chunks
+	idVec[N - 1] = idVec[0];
+	blsSignature sig;
+	CYBOZU_TEST_EQUAL(blsSignatureRecover(&sig, &sigVec[0], &idVec[0], N), -1);
+	CYBOZU_TEST_EQUAL(blsSignatureRecoverMT(&sig, &sigVec[0], &idVec[0], N, 4), -1);
+}
+
+void blsSignatureRecoverRobustTest()
+{
+	const size_t n = 10;
+	const size_t k = 4;
+	blsSecretKey msk[k];
+	blsPublicKey mpk[k];
+	blsId idVec[n];
+	blsSecretKey secVec[n];
+	blsPublicKey pubVec[n];
+	blsSignature sigVec[n];
+	uint8_t okVec[n];
+	uint64_t randVec[n];
+	const char *msg = "message of robust recovery";
+	const size_t msgSize = strlen(msg);
+	cybozu::XorShift rg;
+	for (size_t i = 0; i < n; i++) {
+		randVec[i] = rg.get64();
+	}
+	for (size_t j = 0; j < k; j++) {
+		blsSecretKeySetByCSPRNG(&msk[j]);
+		blsGetPublicKey(&mpk[j], &msk[j]);
+	}
+	for (size_t i = 0; i < n; i++) {
+		blsIdSetInt(&idVec[i], int(i + 1));
+		blsSecretKeyShare(&secVec[i], msk, k, &idVec[i]);
+		blsGetPublicKey(&pubVec[i], &secVec[i]);
+		blsSign(&sigVec[i], &secVec[i], msg, msgSize);
+	}
+	blsSignature sig0, sig;
+	blsSign(&sig0, &msk[0], msg, msgSize);
+	// all shares are valid ; they are not verified one by one
+	CYBOZU_TEST_EQUAL(blsSignatureRecoverRobust(&sig, okVec, sigVec, pubVec, idVec, n, k, &mpk[0], msg, msgSize, randVec, 8), 0);
+	CYBOZU_TEST_ASSERT(blsSignatureIsEqual(&sig, &sig0));
+	for (size_t i = 0; i < n; i++) {
+		CYBOZU_TEST_EQUAL(okVec[i], 2);
+	}
+	// the valid shares of zero or the same ids in the first k are skipped
+	{
+		blsId idVec2[n];
+		blsPublicKey pubVec2[n];
+		blsSignature sigVec2[n];
+		for (size_t i = 0; i < n; i++) {
+			idVec2[i] = idVec[i];
+			pubVec2[i] = pubVec[i];
+			sigVec2[i] = sigVec[i];
+		}
+		idVec2[2] = idVec2[1];
+		pubVec2[2] = pubVec2[1];
+		sigVec2[2] = sigVec2[1];
+		blsSecretKey sec;
+		blsIdSetInt(&idVec2[0], 0);
+		CYBOZU_TEST_EQUAL(blsSecretKeyShare(&sec, msk, k, &idVec2[0]), 0);
+		blsGetPublicKey(&pubVec2[0], &sec);
+		blsSign(&sigVec2[0], &sec, msg, msgSize);
+		CYBOZU_TEST_EQUAL(blsSignatureRecoverRobust(&sig, okVec, sigVec2, pubVec2, idVec2, n, k, &mpk[0], msg, msgSize, randVec, 8), 0);
+		CYBOZU_TEST_ASSERT(blsSignatureIsEqual(&sig, &sig0));
+		for (size_t i = 0; i < n; i++) {
+			CYBOZU_TEST_EQUAL(okVec[i], 1);
+		}
+		// fewer than k distinct nonzero ids among the first 5 shares
+		idVec2[3] = idVec2[1];
+		pubVec2[3] = pubVec2[1];
+		sigVec2[3] = sigVec2[1];
+		CYBOZU_TEST_EQUAL(blsSignatureRecoverRobust(&sig, okVec, sigVec2, pubVec2, idVec2, 5, k, &mpk[0], msg, msgSize, randVec, 8), -1);
+	}
+	// some shares are invalid
+	const size_t badTbl[] = { 0, 3, 7 };
+	for (size_t i = 0; i < CYBOZU_NUM_OF_ARRAY(badTbl); i++) {
+		sigVec[badTbl[i]] = sigVec[badTbl[i] + 1];
+	}
+	CYBOZU_TEST_EQUAL(blsSignatureRecoverRobust(&sig, okVec, sigVec, pubVec, idVec, n, k, &mpk[0], msg, msgSize, randVec, 8), 0);
+	CYBOZU_TEST_ASSERT(blsSignatureIsEqual(&sig, &sig0));
+	for (size_t i = 0; i < n; i++) {
+		const bool bad = i == 0 || i == 3 || i == 7;
+		CYBOZU_TEST_EQUAL(okVec[i], !bad);
+	}
+	// fewer than k valid shares
+	CYBOZU_TEST_EQUAL(blsSignatureRecoverRobust(&sig, okVec, sigVec, pubVec, idVec, 5, k, &mpk[0], msg, msgSize, randVec, 8), -1);
+	CYBOZU_TEST_EQUAL(blsSignatureRecoverRobust(&sig, okVec, sigVec, pubVec, idVec, n, n + 1, &mpk[0], msg, msgSize, randVec, 8), -1);
+}
+
+void blsVerifySameMessageVecTest()
+{
+	const size_t n = 100;
+	std::vector<blsSecretKey> secVec(n);
+	std::vector<blsPublicKey> pubVec(n);
+	std::vector<blsSignature> sigVec(n);
+	std::vector<uint64_t> randVec(n);
+	uint8_t okVec[n];
+	const char *msg = "message of the same";
+	const size_t msgSize = strlen(msg);
+	cybozu::XorShift rg;
+	for (size_t i = 0; i < n; i++) {
+		blsSecretKeySetByCSPRNG(&secVec[i]);
+		blsGetPublicKey(&pubVec[i], &secVec[i]);
+		randVec[i] = rg.get64();
+	}
+	blsSignManyKeys(&sigVec[0], &secVec[0], n, msg, msgSize, 1);
+	for (int threadN = 1; threadN <= 4; threadN *= 2) {
+		CYBOZU_TEST_EQUAL(blsVerifySameMessageVec(okVec, &sigVec[0], &pubVec[0], n, msg, msgSize, &randVec[0], 8, threadN), n);
+		for (size_t i = 0; i < n; i++) {
+			CYBOZU_TEST_EQUAL(okVec[i], 1);
+		}
+	}
+	CYBOZU_TEST_EQUAL(blsVerifySameMessageVec(okVec, &sigVec[0], &pubVec[0], n, "other", 5, &randVec[0], 8, 1), 0u);
+	// invalid signatures and the zero public key
+	sigVec[3] = sigVec[4];
+	sigVec[50] = sigVec[51];
+	blsPublicKeySub(&pubVec[99], &pubVec[99]);
+	blsSignatureSub(&sigVec[99], &sigVec[99]);
+	for (int threadN = 1; threadN <= 4; threadN *= 2) {
+		CYBOZU_TEST_EQUAL(blsVerifySameMessageVec(okVec, &sigVec[0], &pubVec[0], n, msg, msgSize, &randVec[0], 8, threadN), n - 3);
+		for (size_t i = 0; i < n; i++) {
+			CYBOZU_TEST_EQUAL(okVec[i], i != 3 && i != 50 && i != 99);
+		}
+	}
+}
+
+void blsStatsTest()
+{
+	CYBOZU_TEST_EQUAL(strcmp(blsGetStatName(BLS_STAT_MILLER_LOOP), "miller_loop"), 0);
+	CYBOZU_TEST_EQUAL(strcmp(blsGetStatName(BLS_STAT_MUL_VEC), "mul_vec"), 0);
+	CYBOZU_TEST_ASSERT(blsGetStatName(BLS_STAT_N) == 0);
+	CYBOZU_TEST_ASSERT(blsGetStatName(-1) == 0);
+	blsSecretKey sec;
+	blsPublicKey pub;
+	blsSignature sig;
+	const char *msg = "abc";
+	const size_t msgSize = strlen(msg);
+	blsSecretKeySetByCSPRNG(&sec);
+	blsGetPublicKey(&pub, &sec);
+	blsSign(&sig, &sec, msg, msgSize);
+	blsResetStats();
+	const int verifyN = 3;
+	for (int i = 0; i < verifyN; i++) {
+		CYBOZU_TEST_ASSERT(blsVerify(&sig, &pub, msg, msgSize));
+	}
+	CYBOZU_TEST_ASSERT(blsPublicKeyIsValidOrder(&pub));
+	blsStats stats;
+	const int ret = blsGetStats(&stats);
+#ifdef BLS_USE_STATS
+	// make test_stats builds both the library and this test with BLS_USE_STATS
+	CYBOZU_TEST_EQUAL(ret, 0);
+#endif
+	if (ret == 0) {
+		const blsStatEntry& ml = stats.v[BLS_STAT_MILLER_LOOP];
+		CYBOZU_TEST_EQUAL(ml.count, uint64_t(verifyN));
+		CYBOZU_TEST_EQUAL(ml.itemN, uint64_t(verifyN * 2));
+		CYBOZU_TEST_EQUAL(stats.v[BLS_STAT_FINAL_EXP].count, uint64_t(verifyN));
+		CYBOZU_TEST_EQUAL(stats.v[BLS_STAT_HASH_TO_CURVE].count, uint64_t(verifyN));
+		CYBOZU_TEST_EQUAL(stats.v[BLS_STAT_SUBGROUP_CHECK].count, 1u);
+		uint64_t sum = 0;
+		for (size_t i = 0; i < BLS_STATS_BUCKET_N; i++) sum += ml.hist[i];
+		CYBOZU_TEST_EQUAL(sum, ml.count);
+		CYBOZU_TEST_ASSERT(ml.totalNs > 0);
+		blsResetStats();
+		CYBOZU_TEST_EQUAL(blsGetStats(&stats), 0);
+		CYBOZU_TEST_EQUAL(stats.v[BLS_STAT_MILLER_LOOP].count, 0u);
+	} else {
+		// built without BLS_USE_STATS
+		for (size_t i = 0; i < BLS_STAT_N; i++) {
+			CYBOZU_TEST_EQUAL(stats.v[i].count, 0u);
+		}
+	}
+	stats.v[BLS_STAT_FINAL_EXP].count = 12;
+	stats.v[BLS_STAT_FINAL_EXP].totalNs = 345;
+	stats.v[BLS_STAT_FINAL_EXP].hist[4] = 12;
+	std::vector<char> buf(16384);
+	const size_t n = blsStatsToText(&buf[0], buf.size(), &stats);
+	CYBOZU_TEST_ASSERT(n > 0);
+	CYBOZU_TEST_EQUAL(strlen(&buf[0]), n);
+	const std::string text(&buf[0], n);
+	CYBOZU_TEST_ASSERT(text.find("bls_op_latency_ns_bucket{op=\"final_exp\",le=\"16\"} 0\n") != std::string::npos);
+	CYBOZU_TEST_ASSERT(text.find("bls_op_latency_ns_bucket{op=\"final_exp\",le=\"32\"} 12\n") != std::string::npos);
+	CYBOZU_TEST_ASSERT(text.find("bls_op_latency_ns_sum{op=\"final_exp\"} 345\n") != std::string::npos);
+	CYBOZU_TEST_EQUAL(blsStatsToText(&buf[0], n, &stats), 0u);
+}
+
+struct TraceCounter {
+	int v[BLS_PHASE_N][2]; // v[phase][isBegin]
+};
+
+void traceCounterCallback(void *self, int phase, int isBegin, int, mclSize)
+{
+	static_cast<TraceCounter*>(self)->v[phase][isBegin]++;
+}
+
+void blsTraceTest()
+{
+	CYBOZU_TEST_EQUAL(strcmp(blsGetTracePhaseName(BLS_PHASE_BATCH), "batch"), 0);
+	CYBOZU_TEST_EQUAL(strcmp(blsGetTracePhaseName(BLS_PHASE_JOIN), "join"), 0);
+	CYBOZU_TEST_ASSERT(blsGetTracePhaseName(BLS_PHASE_N) == 0);
+	const size_t n = 64;
+	std::vector<blsSecretKey> secVec(n);
+	std::vector<blsPublicKey> pubVec(n);
+	std::vector<blsSignature> sigVec(n);
+	std::vector<uint64_t> randVec(n);
+	uint8_t okVec[n];
+	const char *msg = "trace";
+	const size_t msgSize = strlen(msg);
+	cybozu::XorShift rg;
+	for (size_t i = 0; i < n; i++) {
+		blsSecretKeySetByCSPRNG(&secVec[i]);
+		blsGetPublicKey(&pubVec[i], &secVec[i]);
+		randVec[i] = rg.get64();
+	}
+	blsSignManyKeys(&sigVec[0], &secVec[0], n, msg, msgSize, 1);
+	TraceCounter tc;
+	memset(&tc, 0, sizeof(tc));
+	CYBOZU_TEST_EQUAL(blsSetTraceCallback(traceCounterCallback, &tc), 0);
+	CYBOZU_TEST_EQUAL(blsVerifySameMessageVec(okVec, &sigVec[0], &pubVec[0], n, msg, msgSize, &randVec[0], 8, 1), n);
+	blsSetTraceCallback(0, 0);
+	for (int i = 0; i < BLS_PHASE_N; i++) {
+		CYBOZU_TEST_EQUAL(tc.v[i][0], tc.v[i][1]);
+	}
+	CYBOZU_TEST_EQUAL(tc.v[BLS_PHASE_BATCH][1], 1);
+	CYBOZU_TEST_EQUAL(tc.v[BLS_PHASE_WORKER][1], 1);
+	CYBOZU_TEST_EQUAL(tc.v[BLS_PHASE_HASH][1], 1);
+	CYBOZU_TEST_EQUAL(tc.v[BLS_PHASE_MUL][1], 4); // two chunks of sigVec and pubVec
+	CYBOZU_TEST_EQUAL(tc.v[BLS_PHASE_MILLER_LOOP][1], 1);
+	CYBOZU_TEST_EQUAL(tc.v[BLS_PHASE_FINAL_EXP][1], 1);
+	CYBOZU_TEST_EQUAL(tc.v[BLS_PHASE_JOIN][1], 0);
+	// no event after unregistering
+	CYBOZU_TEST_ASSERT(blsVerify(&sigVec[0], &pubVec[0], msg, msgSize));
+	CYBOZU_TEST_EQUAL(tc.v[BLS_PHASE_HASH][1], 1);
+#ifdef BLS_ETH
+	// one batch of aggregateVerify including the check of the messages
+	{
+		std::vector<uint8_t> msgVec(n * 32);
+		std::vector<blsSignature> sv(n);
+		for (size_t i = 0; i < n; i++) {
+			msgVec[i * 32] = uint8_t(i);
+			blsSign(&sv[i], &secVec[i], &msgVec[i * 32], 32);
+		}
+		blsSignature aggSig;
+		blsAggregateSignature(&aggSig, &sv[0], n);
+		memset(&tc, 0, sizeof(tc));
+		blsSetTraceCallback(traceCounterCallback, &tc);
+		CYBOZU_TEST_ASSERT(blsAggregateVerify(&aggSig, &pubVec[0], &msgVec[0], 32, n));
+		blsSetTraceCallback(0, 0);
+		for (int i = 0; i < BLS_PHASE_N; i++) {
+			CYBOZU_TEST_EQUAL(tc.v[i][0], tc.v[i][1]);
+		}
+		CYBOZU_TEST_EQUAL(tc.v[BLS_PHASE_BATCH][1], 1);
+	}
+#endif
+
+	bls::ChromeTraceRecorder rec;
+	rec.start();
+	CYBOZU_TEST_EQUAL(blsVerifySameMessageVec(okVec, &sigVec[0], &pubVec[0], n, msg, msgSize, &randVec[0], 8, 2), n);
+#ifdef BLS_ETH
+	std::vector<uint8_t> msgVec(n * 32);
+	for (size_t i = 0; i < n; i++) {
+		msgVec[i * 32] = uint8_t(i);
+		blsSign(&sigVec[i], &secVec[i], &msgVec[i * 32], 32);
+	}
+	CYBOZU_TEST_ASSERT(blsMultiVerify(&sigVec[0], &pubVec[0], &msgVec[0], 32, &randVec[0], 8, n, 2));
+#endif
+	rec.stop();
+	CYBOZU_TEST_ASSERT(rec.size() > 0);
+	CYBOZU_TEST_EQUAL(rec.size() % 2, 0u);
+	const std::string json = rec.getJson();
+	CYBOZU_TEST_ASSERT(json.find("{\"name\":\"batch\",\"cat\":\"bls\",\"ph\":\"B\"") != std::string::npos);
+	CYBOZU_TEST_ASSERT(json.find("\"name\":\"miller_loop\"") != std::string::npos);
+	rec.clear();
+	CYBOZU_TEST_EQUAL(rec.size(), 0u);
+	// stop() keeps the callback registered after start()
+	{
+		bls::ChromeTraceRecorder rec2;
+		rec2.start();
+		memset(&tc, 0, sizeof(tc));
+		CYBOZU_TEST_EQUAL(blsSetTraceCallback(traceCounterCallback, &tc), 0);
+		rec2.stop();
+		CYBOZU_TEST_EQUAL(blsVerifySameMessageVec(okVec, &sigVec[0], &pubVec[0], n, msg, msgSize, &randVec[0], 8, 1), n);
+		CYBOZU_TEST_EQUAL(tc.v[BLS_PHASE_BATCH][1], 1);
+		CYBOZU_TEST_EQUAL(rec2.size(), 0u);
+		CYBOZU_TEST_EQUAL(blsClearTraceCallback(traceCounterCallback, &tc), 0);
+		CYBOZU_TEST_EQUAL(blsClearTraceCallback(traceCounterCallback, &tc), -1);
+	}
+}
+
+void blsKeyGenVecTest()
+{
+	const size_t N = 50;
+	blsSecretKey secVec[N], secVec2[N];
+	blsPublicKey pubVec[N], pubVec2[N];
+	const char *seed = "seed of keys";
+	const size_t seedSize = strlen(seed);
+	blsKeyGenVec(secVec, pubVec, N, seed, seedSize, 0, 1);
+	for (size_t i = 0; i < N; i++) {
+		blsPublicKey pub;
+		blsGetPublicKey(&pub, &secVec[i]);
+		CYBOZU_TEST_ASSERT(blsPublicKeyIsEqual(&pub, &pubVec[i]));
+		if (i > 0) CYBOZU_TEST_ASSERT(!blsSecretKeyIsEqual(&secVec[i], &secVec[i - 1]));
+	}
+	// the keys depend only on seed and the index
+	blsKeyGenVec(secVec2, pubVec2, N - 20, seed, seedSize, 20, 4);
+	for (size_t i = 20; i < N; i++) {
+		CYBOZU_TEST_ASSERT(blsSecretKeyIsEqual(&secVec[i], &secVec2[i - 20]));
+		CYBOZU_TEST_ASSERT(blsPublicKeyIsEqual(&pubVec[i], &pubVec2[i - 20]));
+	}
+	blsKeyGenVec(secVec2, pubVec2, 1, seed, seedSize - 1, 0, 1);
+	CYBOZU_TEST_ASSERT(!blsSecretKeyIsEqual(&secVec[0], &secVec2[0]));
+	// the same keys with and without the table of the generator, which blsKeyGenVec does not enable
+	const int w = blsGetGeneratorTableWindow();
+	CYBOZU_TEST_EQUAL(blsSetGeneratorTableWindow(0), 0);
+	blsKeyGenVec(secVec2, pubVec2, N, seed, seedSize, 0, 4);
+	CYBOZU_TEST_EQUAL(blsGetGeneratorTableWindow(), 0);
+	CYBOZU_TEST_EQUAL(blsSetGeneratorTableWindow(blsGetMaxGeneratorTableWindow()), 0);
+	blsKeyGenVec(secVec, pubVec, N, seed, seedSize, 0, 4);
+	for (size_t i = 0; i < N; i++) {
+		CYBOZU_TEST_ASSERT(blsSecretKeyIsEqual(&secVec[i], &secVec2[i]));
+		CYBOZU_TEST_ASSERT(blsPublicKeyIsEqual(&pubVec[i], &pubVec2[i]));
+	}
+	CYBOZU_TEST_EQUAL(blsSetGeneratorTableWindow(w), 0);
+}
+
+void blsVerifyPopVecTest()
+{
+	const size_t n = 40;
+	blsPublicKey pubVec[n];
+	blsSignature popVec[n];
+	uint8_t randVec[n * 8];
+	uint8_t okVec[n];
+	cybozu::XorShift rg;
+	for (size_t i = 0; i < n; i++) {
+		blsSecretKey sec;
+		blsSecretKeySetByCSPRNG(&sec);
+		blsGetPublicKey(&pubVec[i], &sec);
+		blsGetPop(&popVec[i], &sec);
+		for (size_t j = 0; j < 8; j++) randVec[i * 8 + j] = uint8_t(rg.get32());
+	}
+	CYBOZU_TEST_EQUAL(blsVerifyPopVec(okVec, popVec, pubVec, n, randVec, 8), n);
+	for (size_t i = 0; i < n; i++) {
+		CYBOZU_TEST_EQUAL(okVec[i], 1);
+	}
+	// break some PoPs
+	const size_t badTbl[] = { 0, 7, 8, 39 };
+	blsSignatureAdd(&popVec[badTbl[0]], &popVec[1]);
+	blsSignatureAdd(&popVec[badTbl[1]], &popVec[1]);
+	memset(&pubVec[badTbl[2]], 0, sizeof(pubVec[badTbl[2]]));
+	popVec[badTbl[3]] = popVec[1];
+	CYBOZU_TEST_EQUAL(blsVerifyPopVec(okVec, popVec, pubVec, n, randVec, 8), n - CYBOZU_NUM_OF_ARRAY(badTbl));
+	for (size_t i = 0; i < n; i++) {
+		CYBOZU_TEST_EQUAL(okVec[i], blsVerifyPop(&popVec[i], &pubVec[i]));
+	}
+	CYBOZU_TEST_EQUAL(blsVerifyPopVec(okVec, popVec, pubVec, 0, randVec, 8), 0u);
+}
+
+void blsMulVecMTTest()
+{
+	const size_t N = 600;
+	std::vector<blsSecretKey> secVec(N);
+	std::vector<blsPublicKey> pubVec(N);
+	std::vector<blsSignature> sigVec(N);
+	const char *msg = "abc";
+	for (size_t i = 0; i < N; i++) {
+		blsSecretKeySetByCSPRNG(&secVec[i]);
+		blsGetPublicKey(&pubVec[i], &secVec[i]);
+		blsSign(&sigVec[i], &secVec[i], msg, strlen(msg));
+	}
+	const size_t nTbl[] = { 1, 100, 512, N };
+	for (size_t i = 0; i < CYBOZU_NUM_OF_ARRAY(nTbl); i++) {
+		const size_t n = nTbl[i];
+		blsPublicKey pub1, pub2;
+		blsSignature sig1, sig2;
+		blsPublicKeyMulVec(&pub1, &pubVec[0], &secVec[0], n);
+		blsSignatureMulVec(&sig1, &sigVec[0], &secVec[0], n);
+		for (int threadN = 1; threadN <= 4; threadN++) {
+			blsPublicKeyMulVecMT(&pub2, &pubVec[0], &secVec[0], n, threadN);
+			blsSignatureMulVecMT(&sig2, &sigVec[0], &secVec[0], n, threadN);
+			CYBOZU_TEST_ASSERT(blsPublicKeyIsEqual(&pub1, &pub2));
+			CYBOZU_TEST_ASSERT(blsSignatureIsEqual(&sig1, &sig2));
+		}
+	}
+}
+
+// reference implementation of blsAreAllMsgDifferent
+bool areAllMsgDifferentBySet(const void *msgVec, size_t msgSize, size_t n)
+{
+	std::set<std::string> ms;
+	for (size_t i = 0; i < n; i++) {
+		if (!ms.insert(std::string((const char*)msgVec + msgSize * i, msgSize)).second) return false;
+	}
+	return true;
+}
+
+CYBOZU_TEST_AUTO(areAllMsgDifferent)
+{
+	cybozu::XorShift rg;
+	const size_t nTbl[] = { 0, 1, 2, 3, 100, 255, 256, 5000, 20000 };
+	const size_t bufSizeTbl[] = { 0, 100, 24 * 1024, 8 * 20000 + 100, 48 * 20000 };
+	std::vector<char> buf(48 * 20000);
+	for (size_t i = 0; i < CYBOZU_NUM_OF_ARRAY(nTbl); i++) {
+		const size_t n = nTbl[i];
+		// 2-byte messages of 'a'-'z' often collide, 5-byte ones rarely
+		for (size_t msgSize = 2; msgSize <= 5; msgSize += 3) {
+			std::string msgs(msgSize * n + 1, 0);
+			for (size_t j = 0; j < msgs.size(); j++) {
+				msgs[j] = char('a' + rg.get32() % 26);
+			}
+			const int expected = areAllMsgDifferentBySet(msgs.data(), msgSize, n);
+			for (size_t j = 0; j < CYBOZU_NUM_OF_ARRAY(bufSizeTbl); j++) {
+				for (int threadN = 1; threadN <= 4; threadN += 3) {
+					CYBOZU_TEST_EQUAL(blsAreAllMsgDifferent(msgs.data(), msgSize, n, &buf[0], bufSizeTbl[j], threadN), expected);
+				}
+			}
+			CYBOZU_TEST_EQUAL(blsAreAllMsgDifferent(msgs.data(), msgSize, n, 0, 0, 1), expected);
+		}
+	}
+	// messages of the same fingerprint are sorted by their contents
+	{
+		const size_t n = 1000;
+		std::vector<uint32_t> v(n);
+		std::vector<uint64_t> e(n);
+		for (size_t i = 0; i < n; i++) v[i] = uint32_t(i * 7);
+		const bls_util::FixedSizeMsg msgs(&v[0], sizeof(v[0]));
+		for (size_t i = 0; i < n; i++) e[i] = (uint64_t(0x12345678) << 32) | i;
+		CYBOZU_TEST_ASSERT(bls_util::checkMsgEntry(msgs, &e[0], n));
+		v[n / 2] = v[3];
+		for (size_t i = 0; i < n; i++) e[i] = (uint64_t(0x12345678) << 32) | i;
+		CYBOZU_TEST_ASSERT(!bls_util::checkMsgEntry(msgs, &e[0], n));
+	}
+	// a part which does not fit in the table is split
+	{
+		const size_t n = 100;
+		std::vector<uint32_t> v(n);
+		std::vector<uint64_t> e(4);
+		for (size_t i = 0; i < n; i++) v[i] = uint32_t(i * 7);
+		const bls_util::FixedSizeMsg msgs(&v[0], sizeof(v[0]));
+		CYBOZU_TEST_ASSERT(bls_util::checkMsgPart(msgs, n, &e[0], e.size(), 0, 0));
+		v[n / 2] = v[3];
+		CYBOZU_TEST_ASSERT(!bls_util::checkMsgPart(msgs, n, &e[0], e.size(), 0, 0));
+		for (size_t i = 0; i < n; i++) v[i] = 5;
+		CYBOZU_TEST_ASSERT(!bls_util::checkMsgPart(msgs, n, &e[0], e.size(), 0, 0));
+		// many copies of a message without buf
+		std::vector<uint32_t> w(5000, 5);
+		CYBOZU_TEST_EQUAL(blsAreAllMsgDifferent(&w[0], sizeof(w[0]), w.size(), 0, 0, 1), 0);
+		CYBOZU_TEST_EQUAL(blsAreAllMsgDifferent(&w[0], sizeof(w[0]), w.size(), 0, 0, 4), 0);
+	}
+	// variable-length messages which are prefixes of others
+	{
+		const char *msgs = "aababcabcd";
+		const mclSize offsets[] = { 0, 1, 3, 6, 10 };
+		CYBOZU_TEST_EQUAL(blsAreAllMsgDifferentVarLen(msgs, offsets, 4, 0, 0, 1), 1);
+		const mclSize offsets2[] = { 0, 1, 3, 3, 3 }; // two empty messages
+		CYBOZU_TEST_EQUAL(blsAreAllMsgDifferentVarLen(msgs, offsets2, 4, 0, 0, 1), 0);
+	}
+}
+
 CYBOZU_TEST_AUTO(all)
 {
 	const struct {
@@ -445,6 +1341,22 @@ CYBOZU_TEST_AUTO(all)
 			exit(1);
 		}
 		blsMultiAggregateTest();
+		blsMulVecMTTest();
+		blsVerifyPopVecTest();
+		blsSignManyKeysTest();
+		blsSignVecTest();
+		blsGeneratorTableTest();
+		blsContextTest();
+		blsVerifySecretKeyShareVecTest();
+		blsShareVecTest();
+		blsRecoveryPlanTest();
+		blsGetLagrangeCoefficientTest();
+		blsRecoverMTTest();
+		blsSignatureRecoverRobustTest();
+		blsVerifySameMessageVecTest();
+		blsStatsTest();
+		blsTraceTest();
+		blsKeyGenVecTest();
 		bls_use_stackTest();
 		blsDataTest();
 		blsOrderTest(tbl[i].r, tbl[i].p);
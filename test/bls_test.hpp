@@ -7,6 +7,13 @@
 #include <cybozu/atoi.hpp>
 #include <cybozu/file.hpp>
 #include <cybozu/xorshift.hpp>
+#include <bls/msg.hpp>
+#include "../src/sha256.hpp"
+#if MCLBN_FP_UNIT_SIZE == 6 && MCLBN_FR_UNIT_SIZE == 4
+	#include <mcl/bls12_381.hpp>
+	#include "../src/fixed_base.hpp"
+	#define BLS_TEST_FIXED_BASE
+#endif
 #include <iostream>
 #include <fstream>
 #include <vector>
@@ -757,6 +764,50 @@ void blsAggregateVerifyNoCheckTest()
 	blsAggregateVerifyNoCheckTestOne(10, true);
 }
 
+void blsAggregateVerifySameMsgTest()
+{
+	const size_t n = 5;
+	const size_t msgSize = 40;
+	bls::PublicKeyVec pubs(n);
+	bls::SignatureVec sigs(n);
+	std::string msgs(msgSize * n, 0);
+	for (size_t i = 0; i < n; i++) {
+		msgs[msgSize * i + msgSize - 1] = char(i % 3); // msgs[0] == msgs[3], msgs[1] == msgs[4]
+	}
+	for (size_t i = 0; i < n; i++) {
+		bls::SecretKey sec;
+		sec.init();
+		sec.getPublicKey(pubs[i]);
+		sec.sign(sigs[i], &msgs[msgSize * i], msgSize);
+	}
+	blsSignature aggSig;
+	blsAggregateSignature(&aggSig, sigs[0].getPtr(), n);
+	CYBOZU_TEST_EQUAL(blsAggregateVerifyNoCheck(&aggSig, pubs[0].getPtr(), msgs.data(), msgSize, n), 1);
+	CYBOZU_TEST_EQUAL(blsAggregateVerify(&aggSig, pubs[0].getPtr(), msgs.data(), msgSize, n), 0);
+	// the first three messages are different
+	blsAggregateSignature(&aggSig, sigs[0].getPtr(), 3);
+	CYBOZU_TEST_EQUAL(blsAggregateVerify(&aggSig, pubs[0].getPtr(), msgs.data(), msgSize, 3), 1);
+	// more different messages than the table on the stack of the check
+	{
+		const size_t n = 1100;
+		bls::PublicKeyVec pubs(n);
+		bls::SignatureVec sigs(n);
+		std::string msgs(msgSize * n, 0);
+		for (size_t i = 0; i < n; i++) {
+			bls::SecretKey sec;
+			sec.init();
+			sec.getPublicKey(pubs[i]);
+			msgs[msgSize * i] = char(i);
+			msgs[msgSize * i + 1] = char(i >> 8);
+			sec.sign(sigs[i], &msgs[msgSize * i], msgSize);
+		}
+		blsAggregateSignature(&aggSig, sigs[0].getPtr(), n);
+		CYBOZU_TEST_EQUAL(blsAggregateVerify(&aggSig, pubs[0].getPtr(), msgs.data(), msgSize, n), 1);
+		memcpy(&msgs[msgSize * (n - 1)], &msgs[0], msgSize);
+		CYBOZU_TEST_EQUAL(blsAggregateVerify(&aggSig, pubs[0].getPtr(), msgs.data(), msgSize, n), 0);
+	}
+}
+
 void draft07Test()
 {
 	blsSetETHmode(BLS_ETH_MODE_DRAFT_07);
@@ -955,6 +1006,52 @@ void ethMultiVerifyTest()
 	}
 }
 
+void ethVarLenTestOne(size_t n)
+{
+	printf("varLen n=%zd\n", n);
+	cybozu::XorShift rg;
+	bls::PublicKeyVec pubs(n);
+	bls::SignatureVec sigs(n);
+	std::vector<mclSize> offsets(n + 1);
+	offsets[0] = 0;
+	for (size_t i = 0; i < n; i++) {
+		offsets[i + 1] = offsets[i] + (i * 7) % 50 + 1;
+	}
+	std::string msgs(offsets[n], 0);
+	const size_t randSize = 8;
+	std::vector<uint8_t> rands(randSize * n);
+	rg.read(&rands[0], rands.size());
+	rg.read(&msgs[0], msgs.size());
+	for (size_t i = 0; i < n; i++) {
+		msgs[offsets[i]] = char(i); // make all messages different
+		bls::SecretKey sec;
+		sec.init();
+		sec.sign(sigs[i], &msgs[offsets[i]], offsets[i + 1] - offsets[i]);
+		sec.getPublicKey(pubs[i]);
+	}
+	blsSignature aggSig;
+	blsAggregateSignature(&aggSig, sigs[0].getPtr(), n);
+	CYBOZU_TEST_EQUAL(blsAggregateVerifyNoCheckVarLen(&aggSig, pubs[0].getPtr(), msgs.data(), offsets.data(), n), 1);
+	CYBOZU_TEST_EQUAL(blsAggregateVerifyVarLen(&aggSig, pubs[0].getPtr(), msgs.data(), offsets.data(), n), 1);
+#ifndef DISABLE_THREAD_TEST
+	for (int threadN = 1; threadN < 8; threadN += 3) {
+		CYBOZU_TEST_EQUAL(blsMultiVerifyVarLen(sigs[0].getPtr(), pubs[0].getPtr(), msgs.data(), offsets.data(), rands.data(), randSize, n, threadN), 1);
+	}
+#endif
+	msgs[msgs.size() - 1]++;
+	CYBOZU_TEST_EQUAL(blsAggregateVerifyNoCheckVarLen(&aggSig, pubs[0].getPtr(), msgs.data(), offsets.data(), n), 0);
+	CYBOZU_TEST_EQUAL(blsMultiVerifyVarLen(sigs[0].getPtr(), pubs[0].getPtr(), msgs.data(), offsets.data(), rands.data(), randSize, n, 2), 0);
+}
+
+void ethVarLenTest()
+{
+	puts("ethVarLenTest");
+	const size_t nTbl[] = { 1, 2, 16, 17, 50 };
+	for (size_t i = 0; i < CYBOZU_NUM_OF_ARRAY(nTbl); i++) {
+		ethVarLenTestOne(nTbl[i]);
+	}
+}
+
 void makePublicKeyVec(blsSignature *aggSig, blsPublicKey *pubVec, size_t n, int mode, const char *msg, size_t msgSize)
 {
 	blsPublicKey pub;
@@ -1014,12 +1111,75 @@ void ethZeroTest()
 	ethMultiVerifyZeroTest();
 }
 
+void blsSetDstTest()
+{
+	puts("blsSetDstTest");
+	const char *dst = "BLS_SIG_BLS12381G2_XMD:SHA-256_SSWU_RO_NUL_";
+	const char *defaultDst = "BLS_SIG_BLS12381G2_XMD:SHA-256_SSWU_RO_POP_";
+	const char *msg = "abc";
+	const size_t msgSize = strlen(msg);
+	blsSignature h1, h2, h3;
+	blsHashToSignature(&h1, msg, msgSize);
+	CYBOZU_TEST_EQUAL(blsSetDst(dst, strlen(dst)), 0);
+	blsHashToSignature(&h2, msg, msgSize);
+	CYBOZU_TEST_ASSERT(!blsSignatureIsEqual(&h1, &h2));
+	mclBnG2_hashAndMapTo(&h3.v, msg, msgSize);
+	CYBOZU_TEST_ASSERT(blsSignatureIsEqual(&h2, &h3));
+	// the setters of mcl are also used by the signature
+	CYBOZU_TEST_EQUAL(mclBnG2_setDst(defaultDst, strlen(defaultDst)), 0);
+	blsHashToSignature(&h3, msg, msgSize);
+	CYBOZU_TEST_ASSERT(blsSignatureIsEqual(&h1, &h3));
+	CYBOZU_TEST_EQUAL(mclBnG2_setDst(dst, strlen(dst)), 0);
+	blsHashToSignature(&h3, msg, msgSize);
+	CYBOZU_TEST_ASSERT(blsSignatureIsEqual(&h2, &h3));
+	// the batch verifier hashes the messages with the same DST
+	{
+		const size_t n = 40;
+		const size_t msgSize = 32;
+		blsPublicKey pubVec[n];
+		uint8_t msgVec[n * msgSize];
+		blsSignature aggSig;
+		blsSignatureSetHexStr(&aggSig, "c0", 2);
+		for (size_t i = 0; i < n; i++) {
+			blsSecretKey sec;
+			blsSecretKeySetByCSPRNG(&sec);
+			blsGetPublicKey(&pubVec[i], &sec);
+			memset(&msgVec[i * msgSize], int(i), msgSize);
+			blsSignature sig;
+			blsSign(&sig, &sec, &msgVec[i * msgSize], msgSize);
+			if (i == 0) {
+				aggSig = sig;
+			} else {
+				blsSignatureAdd(&aggSig, &sig);
+			}
+		}
+		CYBOZU_TEST_ASSERT(blsAggregateVerifyNoCheck(&aggSig, pubVec, msgVec, msgSize, n));
+		CYBOZU_TEST_EQUAL(blsSetDst(defaultDst, strlen(defaultDst)), 0);
+		CYBOZU_TEST_ASSERT(!blsAggregateVerifyNoCheck(&aggSig, pubVec, msgVec, msgSize, n));
+		// DST set by mcl directly
+		CYBOZU_TEST_EQUAL(mclBnG2_setDst(dst, strlen(dst)), 0);
+		CYBOZU_TEST_ASSERT(blsAggregateVerifyNoCheck(&aggSig, pubVec, msgVec, msgSize, n));
+		CYBOZU_TEST_EQUAL(mclBnG2_setDst(defaultDst, strlen(defaultDst)), 0);
+		CYBOZU_TEST_ASSERT(!blsAggregateVerifyNoCheck(&aggSig, pubVec, msgVec, msgSize, n));
+	}
+	blsHashToSignature(&h2, msg, msgSize);
+	CYBOZU_TEST_ASSERT(blsSignatureIsEqual(&h1, &h2));
+	// blsSetDst accepts what mcl accepts
+	char longDst[256];
+	memset(longDst, 'a', sizeof(longDst));
+	CYBOZU_TEST_EQUAL(blsSetDst(longDst, sizeof(longDst)), mclBnG2_setDst(longDst, sizeof(longDst)));
+	CYBOZU_TEST_EQUAL(blsSetDst(defaultDst, strlen(defaultDst)), 0);
+}
+
 void ethTest(int type)
 {
 	if (type != MCL_BLS12_381) return;
 	ethZeroTest();
 	ethMultiVerifyTest();
+	ethVarLenTest();
 	blsAggregateVerifyNoCheckTest();
+	blsAggregateVerifySameMsgTest();
+	blsSetDstTest();
 	draft07Test();
 	ethSignFileTest("draft07");
 	ethFastAggregateVerifyTest("draft07");
@@ -1048,6 +1208,52 @@ void generatorTest()
 	blsSetGeneratorOfPublicKey(&save);
 }
 
+#ifdef BLS_TEST_FIXED_BASE
+// setTable by the table of init makes the same table as init (misc/precompute.cpp relies on it)
+template<class G>
+void fixedBaseSetTableTest(const G& P)
+{
+	typedef bls_fixed_base::TableT<G, mcl::bn::Fr> Table;
+	static Table t1, t2;
+	const size_t wTbl[] = { 2, Table::getMaxWindow() };
+	for (size_t i = 0; i < CYBOZU_NUM_OF_ARRAY(wTbl); i++) {
+		const size_t w = wTbl[i];
+		CYBOZU_TEST_ASSERT(t1.init(P, w));
+		const size_t n = t1.getTableUnitN();
+		CYBOZU_TEST_ASSERT(!t2.setTable(P, w, t1.getTable(), n - 1));
+		CYBOZU_TEST_ASSERT(t2.setTable(P, w, t1.getTable(), n));
+		CYBOZU_TEST_EQUAL(t2.getWindow(), w);
+		CYBOZU_TEST_EQUAL(t2.getTableUnitN(), n);
+		CYBOZU_TEST_ASSERT(memcmp(t1.getTable(), t2.getTable(), n * sizeof(mcl::Unit)) == 0);
+		CYBOZU_TEST_ASSERT(t2.isBase(P));
+		for (int j = 0; j < 10; j++) {
+			mcl::bn::Fr k;
+			bool b;
+			k.setByCSPRNG(&b);
+			CYBOZU_TEST_ASSERT(b);
+			G Q1, Q2, Q3;
+			t1.mul(Q1, k);
+			t2.mul(Q2, k);
+			G::mul(Q3, P, k);
+			CYBOZU_TEST_ASSERT(Q1 == Q3);
+			CYBOZU_TEST_ASSERT(Q2 == Q3);
+		}
+	}
+}
+
+void fixedBaseTableTest(int type)
+{
+	if (type != MCL_BLS12_381) return;
+	puts("fixedBaseTableTest");
+	mcl::bn::G1 P;
+	mcl::bn::G2 Q;
+	mcl::bn::hashAndMapToG1(P, "abc", 3);
+	mcl::bn::hashAndMapToG2(Q, "abc", 3);
+	fixedBaseSetTableTest(P);
+	fixedBaseSetTableTest(Q);
+}
+#endif
+
 void testAll(int type)
 {
 #if 1
@@ -1062,10 +1268,119 @@ void testAll(int type)
 	hashTest(type);
 	generatorTest();
 #endif
+#ifdef BLS_TEST_FIXED_BASE
+	fixedBaseTableTest(type);
+#endif
 #ifdef BLS_ETH
 	ethTest(type);
 #endif
 }
+// compare with cybozu::Sha256 for the prefixes and suffixes around the block boundaries
+void sha256Test()
+{
+	const size_t maxN = 40;
+	uint8_t prefix[200];
+	uint8_t sufVec[64 * maxN];
+	for (size_t i = 0; i < sizeof(prefix); i++) prefix[i] = uint8_t(i * 7 + 1);
+	for (size_t i = 0; i < sizeof(sufVec); i++) sufVec[i] = uint8_t(i * 13 + 5);
+	const size_t prefixSizeTbl[] = { 0, 1, 32, 55, 56, 63, 64, 65, 96, 119, 120, 128, 200 };
+	const size_t sufSizeTbl[] = { 0, 4, 8, 55, 64 };
+	const size_t nTbl[] = { 1, 3, 8, 9, 16, 17, maxN };
+	for (size_t i = 0; i < CYBOZU_NUM_OF_ARRAY(prefixSizeTbl); i++) {
+		const size_t prefixSize = prefixSizeTbl[i];
+		bls_sha256::Sha256 h0;
+		// split the prefix
+		h0.update(prefix, prefixSize / 3);
+		h0.update(prefix + prefixSize / 3, prefixSize - prefixSize / 3);
+		uint8_t md[32];
+		uint8_t expected[32];
+		h0.digest(md);
+		cybozu::Sha256().digest(expected, sizeof(expected), prefix, prefixSize);
+		CYBOZU_TEST_ASSERT(memcmp(md, expected, sizeof(md)) == 0);
+		for (size_t j = 0; j < CYBOZU_NUM_OF_ARRAY(sufSizeTbl); j++) {
+			const size_t sufSize = sufSizeTbl[j];
+			for (size_t k = 0; k < CYBOZU_NUM_OF_ARRAY(nTbl); k++) {
+				const size_t n = nTbl[k];
+				uint8_t mdVec[32 * maxN];
+				bls_sha256::digestVec(mdVec, h0, sufVec, sufSize, n);
+				for (size_t m = 0; m < n; m++) {
+					cybozu::Sha256 h;
+					h.update(prefix, prefixSize);
+					h.digest(expected, sizeof(expected), sufVec + sufSize * m, sufSize);
+					CYBOZU_TEST_ASSERT(memcmp(mdVec + 32 * m, expected, sizeof(expected)) == 0);
+				}
+			}
+		}
+	}
+}
+
+CYBOZU_TEST_AUTO(sha256)
+{
+	const struct {
+		const char *name;
+		int kernel;
+	} tbl[] = {
+		{ "scalar", bls_sha256::KernelScalar },
+		{ "SHA-NI", bls_sha256::KernelShaNi },
+		{ "AVX2", bls_sha256::KernelAvx2 },
+		{ "AVX-512", bls_sha256::KernelAvx512 },
+	};
+	for (size_t i = 0; i < CYBOZU_NUM_OF_ARRAY(tbl); i++) {
+		const int mask = 1 << tbl[i].kernel;
+		if (i > 0 && !(bls_sha256::getKernelAvailable() & mask)) {
+			printf("sha256 %s kernel is not available\n", tbl[i].name);
+			continue;
+		}
+		printf("sha256 %s kernel\n", tbl[i].name);
+		bls_sha256::setKernelMask(mask);
+		sha256Test();
+	}
+	bls_sha256::setKernelMask(~0);
+	sha256Test();
+}
+
+CYBOZU_TEST_AUTO(expandMsgXmd)
+{
+	// RFC 9380 K.1 expand_message_xmd(SHA-256)
+	const char *dst = "QUUX-V01-CS02-with-expander-SHA256-128";
+	const struct {
+		const char *msg;
+		size_t outSize;
+		const char *expected;
+	} tbl[] = {
+		{ "", 0x20, "68a985b87eb6b46952128911f2a4412bbc302a9d759667f87f7a21d803f07235" },
+		{ "abc", 0x20, "d8ccab23b5985ccea865c6c97b6e5b8350e794e603b4b97902f53a8a0d605615" },
+		{ "abcdef0123456789", 0x80, "ef904a29bffc4cf9ee82832451c946ac3c8f8058ae97d8d629831a74c6572bd9ebd0df635cd1f208e2038e760c4994984ce73f0d55ea9f22af83ba4734569d4bc95e18350f740c07eef653cbb9f87910d833751825f0ebefa1abe5420bb52be14cf489b37fe1a72f7de2d10be453b2c9d9eb20c7e3f6edc5a60629178d9478df" },
+	};
+	bls_sha256::ExpandMsgXmd e;
+	CYBOZU_TEST_ASSERT(e.setDst(dst, strlen(dst)));
+	for (size_t i = 0; i < CYBOZU_NUM_OF_ARRAY(tbl); i++) {
+		Uint8Vec out(tbl[i].outSize);
+		CYBOZU_TEST_ASSERT(e.expand(out.data(), out.size(), tbl[i].msg, strlen(tbl[i].msg)));
+		CYBOZU_TEST_ASSERT(out == fromHexStr(tbl[i].expected));
+	}
+	// expandVec is the same as expand for each message
+	const size_t n = 37;
+	const size_t outSize = 256;
+	char msgVec[n * 100];
+	mclSize msgOffsetVec[n + 1];
+	msgOffsetVec[0] = 0;
+	for (size_t i = 0; i < n; i++) {
+		// the messages of the same size are hashed in parallel
+		const size_t size = i < 20 ? 32 : (i * 7) % 100;
+		for (size_t j = 0; j < size; j++) msgVec[msgOffsetVec[i] + j] = char(i + j);
+		msgOffsetVec[i + 1] = msgOffsetVec[i] + size;
+	}
+	Uint8Vec outVec(outSize * n);
+	const bls_util::VarSizeMsgT<mclSize> msgs(msgVec, msgOffsetVec);
+	CYBOZU_TEST_ASSERT(e.expandVec(outVec.data(), outSize, msgs, n));
+	for (size_t i = 0; i < n; i++) {
+		uint8_t out[outSize];
+		e.expand(out, outSize, &msgVec[msgOffsetVec[i]], msgOffsetVec[i + 1] - msgOffsetVec[i]);
+		CYBOZU_TEST_ASSERT(memcmp(out, &outVec[outSize * i], outSize) == 0);
+	}
+}
+
 CYBOZU_TEST_AUTO(all)
 {
 #ifdef BLS_ETH